@@ -1,5 +1,10 @@
 #include "multiqueue/heap.hpp"
+#include "multiqueue/bucket_queue.hpp"
 #include "multiqueue/buffered_pq.hpp"
+#include "multiqueue/key_value_heap.hpp"
+#include "multiqueue/radix_heap.hpp"
+#include "multiqueue/sequence_heap.hpp"
+#include "multiqueue/utils.hpp"
 
 #ifdef HAVE_BOOST
 #include <boost/heap/d_ary_heap.hpp>
@@ -8,8 +13,15 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_template_test_macros.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <queue>
+#include <random>
+#include <string>
+#include <utility>
 #include <vector>
 
 static constexpr int reps = 500'000;
@@ -188,6 +200,259 @@ TEMPLATE_TEST_CASE_SIG("Degree", "[benchmark][heap][degree]", ((unsigned int Deg
         // to guarantee computation
         return heap.empty();
     };
+
+    std::vector<int> values(reps);
+    std::generate(values.begin(), values.end(), [gen = std::mt19937{1}]() mutable { return static_cast<int>(gen()); });
+
+    BENCHMARK("random") {
+        for (auto v : values) {
+            heap.push(v);
+        }
+        for (int i = 1; i <= reps; ++i) {
+            heap.pop();
+        }
+        // to guarantee computation
+        return heap.empty();
+    };
+}
+
+TEMPLATE_TEST_CASE_SIG("Degree bulk", "[benchmark][heap][degree][bulk]", ((unsigned int Degree), Degree), 2, 4, 8, 16,
+                       64) {
+    using heap_t = multiqueue::Heap<int, std::greater<>, Degree>;
+
+    auto gen = std::mt19937{1};
+    auto values = std::vector<int>(reps);
+    std::generate(values.begin(), values.end(), [&gen]() { return std::uniform_int_distribution<int>{}(gen); });
+
+    BENCHMARK("push") {
+        auto heap = heap_t{};
+        for (auto v : values) {
+            heap.push(v);
+        }
+        // to guarantee computation
+        return heap.size();
+    };
+
+    BENCHMARK("construct") {
+        auto heap = heap_t(values.begin(), values.end());
+        // to guarantee computation
+        return heap.size();
+    };
+
+    BENCHMARK("push_range") {
+        auto heap = heap_t{};
+        for (auto it = values.begin(); it != values.end(); it += reps / 4) {
+            heap.push_range(it, it + reps / 4);
+        }
+        // to guarantee computation
+        return heap.size();
+    };
+}
+
+struct BottomUpOptions : multiqueue::DefaultHeapOptions {
+    static constexpr bool bottom_up = true;
+};
+
+TEMPLATE_TEST_CASE_SIG("Sift down", "[benchmark][heap][bottom_up]", ((unsigned int Degree), Degree), 2, 4, 8, 16) {
+    auto gen = std::mt19937{1};
+    auto values = std::vector<int>(reps);
+    std::generate(values.begin(), values.end(), [&gen]() { return std::uniform_int_distribution<int>{}(gen); });
+
+    auto push_pop = [&values](auto& heap) {
+        for (auto v : values) {
+            heap.push(v);
+        }
+        for (int i = 1; i <= reps; ++i) {
+            heap.pop();
+        }
+        // to guarantee computation
+        return heap.empty();
+    };
+
+    auto top_down_heap = multiqueue::Heap<int, std::greater<>, Degree>{};
+    auto bottom_up_heap = multiqueue::Heap<int, std::greater<>, Degree, std::vector<int>, BottomUpOptions>{};
+
+    BENCHMARK("top_down") {
+        return push_pop(top_down_heap);
+    };
+
+    BENCHMARK("bottom_up") {
+        return push_pop(bottom_up_heap);
+    };
+
+    // Keys with a long common prefix are expensive to compare
+    auto strings = std::vector<std::string>(reps / 4);
+    std::generate(strings.begin(), strings.end(), [&gen]() { return std::string(64, 'a') + std::to_string(gen()); });
+
+    auto push_pop_strings = [&strings](auto& heap) {
+        for (auto const& s : strings) {
+            heap.push(s);
+        }
+        while (!heap.empty()) {
+            heap.pop();
+        }
+        // to guarantee computation
+        return heap.empty();
+    };
+
+    auto top_down_string_heap = multiqueue::Heap<std::string, std::greater<>, Degree>{};
+    auto bottom_up_string_heap =
+        multiqueue::Heap<std::string, std::greater<>, Degree, std::vector<std::string>, BottomUpOptions>{};
+
+    BENCHMARK("top_down_string") {
+        return push_pop_strings(top_down_string_heap);
+    };
+
+    BENCHMARK("bottom_up_string") {
+        return push_pop_strings(bottom_up_string_heap);
+    };
+}
+
+using plain_heap_t = multiqueue::Heap<std::uint64_t, std::greater<>>;
+using aligned_heap_t = multiqueue::AlignedHeap<std::uint64_t, std::greater<>>;
+
+// Heaps larger than the cache, so that popping is dominated by cache misses
+TEMPLATE_TEST_CASE("Layout", "[benchmark][heap][layout]", plain_heap_t, aligned_heap_t) {
+    static constexpr std::size_t size = std::size_t{1} << 23;
+
+    auto gen = std::mt19937_64{1};
+    auto values = std::vector<std::uint64_t>(size);
+    std::generate(values.begin(), values.end(), [&gen]() { return gen(); });
+    auto heap = TestType(values.begin(), values.end());
+
+    BENCHMARK("push_pop") {
+        std::uint64_t sum = 0;
+        for (int i = 1; i <= reps; ++i) {
+            heap.push(gen());
+            sum += heap.top();
+            heap.pop();
+        }
+        // to guarantee computation
+        return sum;
+    };
+}
+
+using sequence_heap_t = multiqueue::SequenceHeap<std::uint64_t, std::greater<>>;
+
+// Random pushes and pops on queues of 2^20 to 2^24 elements
+TEMPLATE_TEST_CASE("Large", "[benchmark][heap][large]", plain_heap_t, aligned_heap_t, sequence_heap_t) {
+    auto gen = std::mt19937_64{1};
+
+    for (int log_size = 20; log_size <= 24; log_size += 2) {
+        auto const size = std::size_t{1} << log_size;
+        auto heap = TestType{};
+        for (std::size_t i = 0; i < size; ++i) {
+            heap.push(gen());
+        }
+
+        BENCHMARK("push_pop_2^" + std::to_string(log_size)) {
+            std::uint64_t sum = 0;
+            for (int i = 1; i <= reps; ++i) {
+                heap.push(gen());
+                sum += heap.top();
+                heap.pop();
+            }
+            // to guarantee computation
+            return sum;
+        };
+    }
+}
+
+// 8-byte keys with 48-byte payloads, stored as pairs or in separate arrays
+using payload_t = std::array<std::uint64_t, 6>;
+using payload_pair_t = std::pair<std::uint64_t, payload_t>;
+using pair_heap_t = multiqueue::Heap<payload_pair_t,
+                                     multiqueue::utils::ValueCompare<payload_pair_t, multiqueue::utils::PairFirst,
+                                                                     std::greater<>>>;
+using key_value_heap_t = multiqueue::KeyValueHeap<std::uint64_t, payload_t, std::greater<>>;
+
+TEMPLATE_TEST_CASE("Key-value layout", "[benchmark][heap][key_value]", pair_heap_t, key_value_heap_t) {
+    auto heap = TestType{};
+
+    auto gen = std::mt19937_64{1};
+    auto keys = std::vector<std::uint64_t>(reps);
+    std::generate(keys.begin(), keys.end(), [&gen]() { return gen(); });
+
+    BENCHMARK("random") {
+        for (auto k : keys) {
+            heap.emplace(k, payload_t{k});
+        }
+        for (int i = 1; i <= reps; ++i) {
+            heap.pop();
+        }
+        // to guarantee computation
+        return heap.empty();
+    };
+
+    BENCHMARK("mixed") {
+        for (auto it = keys.begin(); it != keys.end(); it += 4) {
+            for (auto k = it; k != it + 4; ++k) {
+                heap.emplace(*k, payload_t{*k});
+            }
+            heap.pop();
+            heap.pop();
+            heap.pop();
+        }
+        while (!heap.empty()) {
+            heap.pop();
+        }
+        // to guarantee computation
+        return heap.empty();
+    };
+}
+
+using monotone_heap_t = multiqueue::Heap<std::uint32_t, std::greater<>>;
+using radix_heap_t = multiqueue::RadixHeap<std::uint32_t>;
+
+// Every push is at most 1000 larger than the last popped key, as in Dijkstra's algorithm
+TEMPLATE_TEST_CASE("Monotone", "[benchmark][heap][radix]", monotone_heap_t, radix_heap_t) {
+    auto heap = TestType{};
+
+    auto gen = std::mt19937{1};
+    auto offsets = std::vector<std::uint32_t>(reps);
+    std::generate(offsets.begin(), offsets.end(), [&gen]() { return static_cast<std::uint32_t>(gen() % 1000); });
+
+    BENCHMARK("dijkstra") {
+        std::uint32_t last = 0;
+        for (auto it = offsets.begin(); it != offsets.end(); it += 4) {
+            for (auto o = it; o != it + 4; ++o) {
+                heap.push(last + *o);
+            }
+            last = heap.top();
+            heap.pop();
+            heap.pop();
+            heap.pop();
+        }
+        while (!heap.empty()) {
+            heap.pop();
+        }
+        // to guarantee computation
+        return last;
+    };
+}
+
+using small_range_heap_t = multiqueue::Heap<int, std::greater<>>;
+using bucket_queue_t = multiqueue::BucketQueue<int>;
+
+TEMPLATE_TEST_CASE("Small range", "[benchmark][heap][bucket]", small_range_heap_t, bucket_queue_t) {
+    auto heap = TestType{};
+
+    auto gen = std::mt19937{1};
+    auto keys = std::vector<int>(reps);
+    std::generate(keys.begin(), keys.end(), [&gen]() { return static_cast<int>(gen() % 4096); });
+
+    BENCHMARK("random") {
+        for (auto k : keys) {
+            heap.push(k);
+        }
+        int sum = 0;
+        while (!heap.empty()) {
+            sum += heap.top();
+            heap.pop();
+        }
+        // to guarantee computation
+        return sum;
+    };
 }
 
 TEMPLATE_TEST_CASE_SIG("BufferedPQ", "[benchmark][buffered_pq]", ((unsigned int Buffersize), Buffersize), 4, 8, 16, 64,
@@ -250,6 +515,94 @@ TEMPLATE_TEST_CASE_SIG("BufferedPQ", "[benchmark][buffered_pq]", ((unsigned int
     };
 }
 
+// Every popped event schedules a new event shortly after it, so that many pushes go into the deletion buffer
+TEMPLATE_TEST_CASE_SIG("BufferedPQ events", "[benchmark][buffered_pq][events]", ((unsigned int Buffersize), Buffersize),
+                       16, 64) {
+    using pq_t = multiqueue::BufferedPQ<multiqueue::Heap<long, std::greater<>>, 16, Buffersize>;
+
+    auto pq = pq_t{};
+    for (long i = 0; i < 40; ++i) {
+        pq.push(i * 100);
+    }
+    auto gen = std::mt19937{1};
+    auto delays = std::vector<long>(reps);
+    std::generate(delays.begin(), delays.end(), [&gen]() { return 1 + static_cast<long>(gen() % (100 * Buffersize)); });
+
+    BENCHMARK("simulate") {
+        long sum = 0;
+        for (auto d : delays) {
+            auto const now = pq.top();
+            pq.pop();
+            pq.push(now + d);
+            sum += now;
+        }
+        // to guarantee computation
+        return sum;
+    };
+}
+
+// The buffer size is the maximum capacity of the adaptive buffers
+TEMPLATE_TEST_CASE_SIG("BufferedPQ adaptive", "[benchmark][buffered_pq][adaptive]",
+                       ((unsigned int Buffersize), Buffersize), 16, 64, 256) {
+    using pq_t = multiqueue::BufferedPQ<multiqueue::Heap<int, std::less<>>, Buffersize, Buffersize,
+                                        multiqueue::AdaptiveBufferedPQOptions>;
+
+    auto pq = pq_t{};
+
+    BENCHMARK("up") {
+        for (int i = 1; i <= reps; ++i) {
+            pq.push(i);
+        }
+        for (int i = 1; i <= reps; ++i) {
+            pq.pop();
+        }
+        // to guarantee computation
+        return pq.empty();
+    };
+
+    BENCHMARK("down") {
+        for (int i = reps; i > 0; --i) {
+            pq.push(i);
+        }
+        for (int i = 1; i <= reps; ++i) {
+            pq.pop();
+        }
+        // to guarantee computation
+        return pq.empty();
+    };
+
+    BENCHMARK("up_down") {
+        for (int i = 1; i <= reps / 2; ++i) {
+            pq.push(i);
+        }
+        for (int i = reps; i > reps / 2; --i) {
+            pq.push(i);
+        }
+        for (int i = 1; i <= reps; ++i) {
+            pq.pop();
+        }
+        // to guarantee computation
+        return pq.empty();
+    };
+
+    BENCHMARK("mixed") {
+        for (int i = 1; i <= reps / 4; ++i) {
+            pq.push(i * 3);
+            pq.push(i);
+            pq.push(i * 4);
+            pq.push(i * 2);
+            pq.pop();
+            pq.pop();
+            pq.pop();
+        }
+        for (int i = 1; i <= reps / 4; ++i) {
+            pq.pop();
+        }
+        // to guarantee computation
+        return pq.empty();
+    };
+}
+
 TEMPLATE_TEST_CASE_SIG("BufferedPQ std::pq", "[benchmark][buffered_pq]", ((unsigned int Buffersize), Buffersize), 4, 8,
                        16, 64, 256) {
     using pq_t =
@@ -0,0 +1,274 @@
+/**
+******************************************************************************
+* @file:   mq_throughput.cpp
+*
+* @brief:  Measures the throughput of the multiqueue with multiple threads
+*
+* Workloads:
+*   alternating: Every thread alternates between pushing and popping
+*   drain:       The queue is prefilled, then all threads pop until it is empty
+*   split:       Half of the threads push, the other half pops until the
+*                multiqueue terminates
+*******************************************************************************
+**/
+
+#include "multiqueue/modes/hierarchical.hpp"
+#include "multiqueue/modes/random.hpp"
+#include "multiqueue/modes/stick_random.hpp"
+#include "multiqueue/modes/stick_swap.hpp"
+#include "multiqueue/multiqueue.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Settings {
+    std::string mode = "random";
+    std::string workload = "alternating";
+    unsigned int num_threads = 4;
+    unsigned int factor = 2;
+    int stickiness = 16;
+    int cores_per_domain = 0;
+    std::size_t prefill = 1'000'000;
+    std::size_t ops_per_thread = 1'000'000;
+    double remote_chance = 0.1;
+    bool pin = true;
+    int seed = 1;
+};
+
+template <typename Mode>
+struct Policy {
+    using mode_type = Mode;
+    static constexpr int pop_tries = 1;
+    static constexpr bool scan = true;
+};
+
+using key_type = std::uint64_t;
+
+void pin_to_core(unsigned int id) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(id % std::max(std::thread::hardware_concurrency(), 1U), &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        std::cerr << "Failed to pin thread " << id << '\n';
+    }
+}
+
+// Runs `work(id, state)` on `num_threads` threads which start at the same time and returns the elapsed time. Each
+// thread creates its `state = init(id)` after it is pinned and before any thread starts working.
+template <typename Init, typename Work>
+std::chrono::duration<double> run_parallel(Settings const& settings, Init&& init, Work&& work) {
+    std::atomic_uint ready{0};
+    std::atomic_bool start{false};
+    auto thread_main = [&](unsigned int id) {
+        if (settings.pin) {
+            pin_to_core(id);
+        }
+        auto state = init(id);
+        ready.fetch_add(1, std::memory_order_acq_rel);
+        while (!start.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        work(id, state);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int id = 0; id < settings.num_threads; ++id) {
+        threads.emplace_back(thread_main, id);
+    }
+    while (ready.load(std::memory_order_acquire) != settings.num_threads) {
+        std::this_thread::yield();
+    }
+    auto const start_time = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& t : threads) {
+        t.join();
+    }
+    return std::chrono::steady_clock::now() - start_time;
+}
+
+template <typename Mode>
+void run(Settings const& settings) {
+    using mq_type = multiqueue::ValueMultiQueue<key_type, std::greater<>, Policy<Mode>>;
+
+    auto config = typename mq_type::config_type{};
+    config.seed = settings.seed;
+    if constexpr (std::is_same_v<Mode, multiqueue::mode::Hierarchical<>>) {
+        config.cores_per_domain = settings.cores_per_domain;
+    } else {
+        if constexpr (!std::is_same_v<Mode, multiqueue::mode::Random<>>) {
+            config.stickiness = settings.stickiness;
+        }
+        if constexpr (!std::is_same_v<Mode, multiqueue::mode::StickSwap<>>) {
+            config.numa_remote_chance = settings.remote_chance;
+        }
+    }
+    std::size_t num_pqs = 1;
+    while (num_pqs < static_cast<std::size_t>(settings.factor) * settings.num_threads) {
+        num_pqs *= 2;
+    }
+    // Keys stay far below the maximum key, which is the sentinel
+    auto key_dist = std::uniform_int_distribution<key_type>(0, (key_type{1} << 32) - 1);
+
+    std::vector<key_type> initial(settings.workload == "split" ? 0 : settings.prefill);
+    {
+        auto gen = std::mt19937_64(static_cast<std::uint64_t>(settings.seed));
+        std::generate(initial.begin(), initial.end(), [&] { return key_dist(gen); });
+    }
+    mq_type mq(num_pqs, initial.begin(), initial.end(), settings.num_threads, config);
+
+    // Every thread creates its handle after it is pinned, so that the handle samples the queues of its own NUMA node
+    // and cache domain. All handles exist before any thread starts, so blocking pops cannot terminate prematurely.
+    auto make_handle = [&mq](unsigned int /*id*/) { return mq.get_handle(); };
+    std::vector<std::size_t> num_ops(settings.num_threads);
+
+    std::chrono::duration<double> elapsed{};
+    if (settings.workload == "alternating") {
+        elapsed = run_parallel(settings, make_handle, [&](unsigned int id, auto& handle) {
+            auto gen = std::mt19937_64(static_cast<std::uint64_t>(settings.seed) + id + 1);
+            std::size_t ops = 0;
+            for (std::size_t i = 0; i < settings.ops_per_thread; ++i) {
+                handle.push(key_dist(gen));
+                ++ops;
+                if (handle.try_pop()) {
+                    ++ops;
+                }
+            }
+            num_ops[id] = ops;
+        });
+    } else if (settings.workload == "drain") {
+        elapsed = run_parallel(settings, make_handle, [&](unsigned int id, auto& handle) {
+            std::size_t ops = 0;
+            while (handle.try_pop()) {
+                ++ops;
+            }
+            num_ops[id] = ops;
+        });
+    } else if (settings.workload == "split") {
+        elapsed = run_parallel(settings, make_handle, [&](unsigned int id, auto& handle) {
+            // Even threads produce, odd threads consume
+            std::size_t ops = 0;
+            if (id % 2 == 0) {
+                auto gen = std::mt19937_64(static_cast<std::uint64_t>(settings.seed) + id + 1);
+                for (std::size_t i = 0; i < settings.ops_per_thread; ++i) {
+                    handle.push(key_dist(gen));
+                    ++ops;
+                }
+            } else {
+                while (handle.pop()) {
+                    ++ops;
+                }
+            }
+            num_ops[id] = ops;
+        });
+    } else {
+        std::cerr << "Unknown workload " << settings.workload << '\n';
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::size_t total_ops = 0;
+    for (auto ops : num_ops) {
+        total_ops += ops;
+    }
+    std::cout << "mode " << settings.mode << " workload " << settings.workload << " threads " << settings.num_threads
+              << " pqs " << num_pqs << " stickiness " << settings.stickiness << " nodes " << mq.num_nodes() << '\n';
+    std::cout << "ops " << total_ops << " time " << elapsed.count() << " s throughput "
+              << static_cast<double>(total_ops) / elapsed.count() << " ops/s\n";
+}
+
+void print_usage(char const* name) {
+    std::cerr << "Usage: " << name << " [options]\n"
+              << "  -m <mode>      random, stick_random, stick_swap or hierarchical (default: random)\n"
+              << "  -w <workload>  alternating, drain or split (default: alternating)\n"
+              << "  -j <threads>   number of threads (default: 4)\n"
+              << "  -c <factor>    queues per thread, rounded up to a power of two (default: 2)\n"
+              << "  -s <stick>     stickiness (default: 16)\n"
+              << "  -p <prefill>   number of elements to prefill (default: 1000000)\n"
+              << "  -n <ops>       pushes per thread (default: 1000000)\n"
+              << "  -r <seed>      random seed (default: 1)\n"
+              << "  -x <chance>    chance to sample a queue of a remote NUMA node (default: 0.1)\n"
+              << "  -l <cores>     cores per cache domain of mode hierarchical, 0 to read sysfs (default: 0)\n"
+              << "  -u             do not pin threads to cores\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-u") {
+            settings.pin = false;
+            continue;
+        }
+        if (arg == "-h" || i + 1 == argc) {
+            print_usage(argv[0]);
+            return arg == "-h" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "-m") {
+            settings.mode = value;
+        } else if (arg == "-w") {
+            settings.workload = value;
+        } else if (arg == "-j") {
+            settings.num_threads = static_cast<unsigned int>(std::stoul(value));
+        } else if (arg == "-c") {
+            settings.factor = static_cast<unsigned int>(std::stoul(value));
+        } else if (arg == "-s") {
+            settings.stickiness = std::stoi(value);
+        } else if (arg == "-p") {
+            settings.prefill = std::stoul(value);
+        } else if (arg == "-n") {
+            settings.ops_per_thread = std::stoul(value);
+        } else if (arg == "-r") {
+            settings.seed = std::stoi(value);
+        } else if (arg == "-x") {
+            settings.remote_chance = std::stod(value);
+        } else if (arg == "-l") {
+            settings.cores_per_domain = std::stoi(value);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (settings.num_threads == 0) {
+        std::cerr << "Number of threads must be positive\n";
+        return EXIT_FAILURE;
+    }
+    if (settings.workload == "split" && settings.num_threads < 2) {
+        std::cerr << "Workload split needs at least two threads\n";
+        return EXIT_FAILURE;
+    }
+    if (settings.mode == "stick_swap" && settings.factor < 2) {
+        std::cerr << "Mode stick_swap needs at least two queues per thread\n";
+        return EXIT_FAILURE;
+    }
+
+    if (settings.mode == "random") {
+        run<multiqueue::mode::Random<>>(settings);
+    } else if (settings.mode == "stick_random") {
+        run<multiqueue::mode::StickRandom<>>(settings);
+    } else if (settings.mode == "stick_swap") {
+        run<multiqueue::mode::StickSwap<>>(settings);
+    } else if (settings.mode == "hierarchical") {
+        run<multiqueue::mode::Hierarchical<>>(settings);
+    } else {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
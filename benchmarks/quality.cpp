@@ -0,0 +1,314 @@
+/**
+******************************************************************************
+* @file:   quality.cpp
+*
+* @brief:  Measures rank error and delay of the multiqueue
+*
+* Every thread logs its operations with a timestamp. The logs are merged and
+* replayed against an exact structure afterwards. Pushes are timestamped before
+* and pops after the operation, so an element is always pushed before it is
+* popped in the replay. The rank error of a pop is the number of elements in the
+* queue with a better key than the popped one. The delay of an element is the
+* number of worse elements popped while it was in the queue.
+*******************************************************************************
+**/
+
+#include "multiqueue/modes/hierarchical.hpp"
+#include "multiqueue/modes/random.hpp"
+#include "multiqueue/modes/stick_random.hpp"
+#include "multiqueue/modes/stick_swap.hpp"
+#include "multiqueue/multiqueue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Settings {
+    std::string mode = "random";
+    unsigned int num_threads = 4;
+    unsigned int factor = 2;
+    int stickiness = 16;
+    int cores_per_domain = 0;
+    std::size_t prefill = 100'000;
+    std::size_t ops_per_thread = 100'000;
+    bool monotone = false;
+    int seed = 1;
+};
+
+template <typename Mode>
+struct Policy {
+    using mode_type = Mode;
+    static constexpr int pop_tries = 1;
+    static constexpr bool scan = true;
+};
+
+using key_type = std::uint64_t;
+using id_type = std::uint64_t;
+using clock_type = std::chrono::steady_clock;
+
+struct LogEntry {
+    clock_type::time_point time;
+    key_type key;
+    id_type id;
+    bool is_pop;
+};
+
+struct Element {
+    key_type key;
+    id_type id;
+
+    friend bool operator<(Element const& lhs, Element const& rhs) noexcept {
+        return std::pair{lhs.key, lhs.id} < std::pair{rhs.key, rhs.id};
+    }
+};
+
+class FenwickTree {
+    std::vector<std::int64_t> tree_;
+
+   public:
+    explicit FenwickTree(std::size_t n) : tree_(n + 1, 0) {
+    }
+
+    void add(std::size_t index, std::int64_t value) noexcept {
+        for (++index; index < tree_.size(); index += index & (~index + 1)) {
+            tree_[index] += value;
+        }
+    }
+
+    // Sum of the values at indices [0, index)
+    [[nodiscard]] std::int64_t prefix_sum(std::size_t index) const noexcept {
+        std::int64_t sum = 0;
+        for (; index > 0; index -= index & (~index + 1)) {
+            sum += tree_[index];
+        }
+        return sum;
+    }
+};
+
+struct Summary {
+    double mean{};
+    std::uint64_t p99{};
+    std::uint64_t max{};
+};
+
+Summary summarize(std::vector<std::uint64_t> values) {
+    Summary s;
+    if (values.empty()) {
+        return s;
+    }
+    std::sort(values.begin(), values.end());
+    long double sum = 0;
+    for (auto v : values) {
+        sum += static_cast<long double>(v);
+    }
+    s.mean = static_cast<double>(sum / static_cast<long double>(values.size()));
+    s.p99 = values[(values.size() - 1) * 99 / 100];
+    s.max = values.back();
+    return s;
+}
+
+// Replays the merged log and computes the rank error of every pop and the delay of every popped element
+std::pair<Summary, Summary> replay(std::vector<LogEntry> log) {
+    std::stable_sort(log.begin(), log.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.time < rhs.time || (lhs.time == rhs.time && !lhs.is_pop && rhs.is_pop);
+    });
+    std::vector<Element> elements;
+    for (auto const& e : log) {
+        if (!e.is_pop) {
+            elements.push_back({e.key, e.id});
+        }
+    }
+    std::sort(elements.begin(), elements.end());
+    auto rank_of = [&elements](key_type key, id_type id) {
+        return static_cast<std::size_t>(std::lower_bound(elements.begin(), elements.end(), Element{key, id}) -
+                                        elements.begin());
+    };
+
+    // Elements currently in the queue and elements popped so far, indexed by rank
+    FenwickTree present(elements.size());
+    FenwickTree popped(elements.size());
+    std::int64_t num_popped = 0;
+    std::vector<std::int64_t> worse_popped_at_push(elements.size());
+
+    std::vector<std::uint64_t> rank_errors;
+    std::vector<std::uint64_t> delays;
+    for (auto const& e : log) {
+        auto const rank = rank_of(e.key, e.id);
+        if (!e.is_pop) {
+            present.add(rank, 1);
+            worse_popped_at_push[rank] = num_popped - popped.prefix_sum(rank + 1);
+        } else {
+            present.add(rank, -1);
+            // Elements with equal keys do not count as better
+            auto const first_equal = rank_of(e.key, 0);
+            rank_errors.push_back(static_cast<std::uint64_t>(present.prefix_sum(first_equal)));
+            auto const worse_popped = num_popped - popped.prefix_sum(rank + 1);
+            delays.push_back(static_cast<std::uint64_t>(worse_popped - worse_popped_at_push[rank]));
+            popped.add(rank, 1);
+            ++num_popped;
+        }
+    }
+    return {summarize(std::move(rank_errors)), summarize(std::move(delays))};
+}
+
+template <typename Mode>
+void run(Settings const& settings) {
+    using mq_type = multiqueue::KeyValueMultiQueue<key_type, id_type, std::greater<>, Policy<Mode>>;
+
+    auto config = typename mq_type::config_type{};
+    config.seed = settings.seed;
+    if constexpr (std::is_same_v<Mode, multiqueue::mode::Hierarchical<>>) {
+        config.cores_per_domain = settings.cores_per_domain;
+    } else if constexpr (!std::is_same_v<Mode, multiqueue::mode::Random<>> &&
+                         !std::is_same_v<Mode, multiqueue::mode::Random<2, false>>) {
+        config.stickiness = settings.stickiness;
+    }
+    std::size_t num_pqs = 1;
+    while (num_pqs < static_cast<std::size_t>(settings.factor) * settings.num_threads) {
+        num_pqs *= 2;
+    }
+    mq_type mq(num_pqs, config);
+
+    // Keys stay far below the maximum key, which is the sentinel
+    auto key_dist = std::uniform_int_distribution<key_type>(0, (key_type{1} << 32) - 1);
+    std::vector<std::vector<LogEntry>> logs(settings.num_threads);
+    for (unsigned int t = 0; t < settings.num_threads; ++t) {
+        logs[t].reserve(2 * settings.ops_per_thread + (t == 0 ? settings.prefill : 0));
+    }
+    {
+        auto handle = mq.get_handle();
+        auto gen = std::mt19937_64(static_cast<std::uint64_t>(settings.seed));
+        auto const start = clock_type::now();
+        for (std::size_t i = 0; i < settings.prefill; ++i) {
+            key_type key = key_dist(gen);
+            id_type id = i << 8;
+            handle.push({key, id});
+            logs[0].push_back({start, key, id, false});
+        }
+    }
+
+    auto work = [&](unsigned int t) {
+        // The handle is created by the thread using it, so that it belongs to the cache domain of this thread
+        auto handle = mq.get_handle();
+        auto& log = logs[t];
+        auto gen = std::mt19937_64(static_cast<std::uint64_t>(settings.seed) + t + 1);
+        key_type last_popped = 0;
+        for (std::size_t i = 0; i < settings.ops_per_thread; ++i) {
+            key_type key = settings.monotone ? last_popped + (key_dist(gen) >> 16) : key_dist(gen);
+            // The thread id is encoded in the lower bits to make ids unique
+            id_type id = ((settings.prefill + i) << 8) | t;
+            log.push_back({clock_type::now(), key, id, false});
+            handle.push({key, id});
+            auto v = handle.try_pop();
+            if (v) {
+                log.push_back({clock_type::now(), v->first, v->second, true});
+                last_popped = v->first;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < settings.num_threads; ++t) {
+        threads.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::vector<LogEntry> log;
+    for (auto const& l : logs) {
+        log.insert(log.end(), l.begin(), l.end());
+    }
+    auto [rank_error, delay] = replay(std::move(log));
+    std::cout << "mode " << settings.mode << " threads " << settings.num_threads << " pqs " << num_pqs
+              << " stickiness " << settings.stickiness << '\n';
+    std::cout << "rank_error mean " << rank_error.mean << " p99 " << rank_error.p99 << " max " << rank_error.max
+              << '\n';
+    std::cout << "delay mean " << delay.mean << " p99 " << delay.p99 << " max " << delay.max << '\n';
+}
+
+void print_usage(char const* name) {
+    std::cerr << "Usage: " << name << " [options]\n"
+              << "  -m <mode>     random, random_nonstale, stick_random, stick_swap or hierarchical (default: random)\n"
+              << "  -j <threads>  number of threads (default: 4)\n"
+              << "  -c <factor>   queues per thread, rounded up to a power of two (default: 2)\n"
+              << "  -s <stick>    stickiness (default: 16)\n"
+              << "  -p <prefill>  number of elements to prefill (default: 100000)\n"
+              << "  -n <ops>      push/pop pairs per thread (default: 100000)\n"
+              << "  -r <seed>     random seed (default: 1)\n"
+              << "  -l <cores>    cores per cache domain of mode hierarchical, 0 to read sysfs (default: 0)\n"
+              << "  -d            monotone (Dijkstra-like) keys\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-d") {
+            settings.monotone = true;
+            continue;
+        }
+        if (arg == "-h" || i + 1 == argc) {
+            print_usage(argv[0]);
+            return arg == "-h" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "-m") {
+            settings.mode = value;
+        } else if (arg == "-j") {
+            settings.num_threads = static_cast<unsigned int>(std::stoul(value));
+        } else if (arg == "-c") {
+            settings.factor = static_cast<unsigned int>(std::stoul(value));
+        } else if (arg == "-s") {
+            settings.stickiness = std::stoi(value);
+        } else if (arg == "-l") {
+            settings.cores_per_domain = std::stoi(value);
+        } else if (arg == "-p") {
+            settings.prefill = std::stoul(value);
+        } else if (arg == "-n") {
+            settings.ops_per_thread = std::stoul(value);
+        } else if (arg == "-r") {
+            settings.seed = std::stoi(value);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (settings.num_threads == 0 || settings.num_threads > 255) {
+        std::cerr << "Number of threads must be in [1, 255]\n";
+        return EXIT_FAILURE;
+    }
+    if (settings.mode == "stick_swap" && settings.factor < 2) {
+        std::cerr << "Mode stick_swap needs at least two queues per thread\n";
+        return EXIT_FAILURE;
+    }
+
+    if (settings.mode == "random") {
+        run<multiqueue::mode::Random<>>(settings);
+    } else if (settings.mode == "random_nonstale") {
+        run<multiqueue::mode::Random<2, false>>(settings);
+    } else if (settings.mode == "stick_random") {
+        run<multiqueue::mode::StickRandom<>>(settings);
+    } else if (settings.mode == "stick_swap") {
+        run<multiqueue::mode::StickSwap<>>(settings);
+    } else if (settings.mode == "hierarchical") {
+        run<multiqueue::mode::Hierarchical<>>(settings);
+    } else {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,222 @@
+/**
+******************************************************************************
+* @file:   bucket_queue.hpp
+*
+* @brief:  Bucket queue for integer keys from a small range
+*******************************************************************************
+**/
+#pragma once
+
+#include "multiqueue/utils.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace multiqueue {
+
+// A bucket queue (Dial, 1969) for integer keys in [0, num_buckets). Compare must be `std::greater` for a min-queue or
+// `std::less` for a max-queue. There is one bucket per key and a two-level bitmap of the nonempty buckets, so pushing
+// takes constant time and popping takes time linear in the number of bitmap words skipped to find the next nonempty
+// bucket, which is constant for the default range. Values with the same key are popped in LIFO order.
+template <typename Value, typename KeyOfValue = utils::Identity, typename Compare = std::greater<>,
+          std::size_t num_buckets = 4096>
+class BucketQueue {
+    static_assert(num_buckets >= 1, "There must be at least one bucket");
+
+   public:
+    using value_type = Value;
+    using key_type = std::decay_t<decltype(KeyOfValue::get(std::declval<Value const &>()))>;
+    using key_compare = Compare;
+    using value_compare = utils::ValueCompare<Value, KeyOfValue, Compare>;
+    using reference = value_type &;
+    using const_reference = value_type const &;
+    using size_type = std::size_t;
+
+    static_assert(std::is_integral_v<key_type>, "The keys must be integers");
+
+   protected:
+    // NOLINTNEXTLINE(cppcoreguidelines-non-private-member-variables-in-classes): Compatibility to Heap
+    [[no_unique_address]] value_compare comp;
+
+   private:
+    using word_type = std::uint64_t;
+    static constexpr std::size_t bits_per_word = 64;
+    static constexpr std::size_t num_words = (num_buckets + bits_per_word - 1) / bits_per_word;
+    static constexpr std::size_t num_summary_words = (num_words + bits_per_word - 1) / bits_per_word;
+    static constexpr bool max_queue =
+        std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<key_type>>;
+    static_assert(max_queue || std::is_same_v<Compare, std::greater<>> ||
+                      std::is_same_v<Compare, std::greater<key_type>>,
+                  "Compare must be std::less or std::greater");
+
+    // Ordered such that the top element is in the nonempty bucket with the lowest index
+    std::vector<std::vector<value_type>> buckets_;
+    std::array<word_type, num_words> words_{};
+    // Bit `i` is set if word `i` is nonzero
+    std::array<word_type, num_summary_words> summary_{};
+    // The lowest nonempty bucket, or `num_buckets` if the queue is empty
+    std::size_t top_bucket_{num_buckets};
+    size_type size_{0};
+
+    static std::size_t bucket_of(value_type const &value) noexcept {
+        auto const key = KeyOfValue::get(value);
+        assert(is_valid_key(key));
+        auto const index = static_cast<std::size_t>(key);
+        if constexpr (max_queue) {
+            return num_buckets - 1 - index;
+        } else {
+            return index;
+        }
+    }
+
+    static std::size_t count_trailing_zeros(word_type w) noexcept {
+        assert(w != 0);
+        return static_cast<std::size_t>(__builtin_ctzll(w));
+    }
+
+    void set(std::size_t bucket) noexcept {
+        auto const w = bucket / bits_per_word;
+        words_[w] |= word_type{1} << (bucket % bits_per_word);
+        summary_[w / bits_per_word] |= word_type{1} << (w % bits_per_word);
+    }
+
+    void reset(std::size_t bucket) noexcept {
+        auto const w = bucket / bits_per_word;
+        words_[w] &= ~(word_type{1} << (bucket % bits_per_word));
+        if (words_[w] == 0) {
+            summary_[w / bits_per_word] &= ~(word_type{1} << (w % bits_per_word));
+        }
+    }
+
+    // Returns the first nonempty bucket not before `first`, or `num_buckets` if there is none
+    [[nodiscard]] std::size_t find_first(std::size_t first) const noexcept {
+        if (first >= num_buckets) {
+            return num_buckets;
+        }
+        auto w = first / bits_per_word;
+        if (auto const word = words_[w] & (~word_type{0} << (first % bits_per_word)); word != 0) {
+            return w * bits_per_word + count_trailing_zeros(word);
+        }
+        ++w;
+        while (w < num_words) {
+            auto const s = w / bits_per_word;
+            if (auto const summary = summary_[s] & (~word_type{0} << (w % bits_per_word)); summary != 0) {
+                auto const next = s * bits_per_word + count_trailing_zeros(summary);
+                return next * bits_per_word + count_trailing_zeros(words_[next]);
+            }
+            w = (s + 1) * bits_per_word;
+        }
+        return num_buckets;
+    }
+
+    template <typename V>
+    void insert(V &&value) {
+        auto const b = bucket_of(value);
+        if (buckets_[b].empty()) {
+            set(b);
+            if (b < top_bucket_) {
+                top_bucket_ = b;
+            }
+        }
+        buckets_[b].push_back(std::forward<V>(value));
+        ++size_;
+    }
+
+   public:
+    // Returns whether `key` is in [0, num_buckets)
+    static constexpr bool is_valid_key(key_type key) noexcept {
+        if constexpr (std::is_signed_v<key_type>) {
+            if (key < 0) {
+                return false;
+            }
+        }
+        return static_cast<std::make_unsigned_t<key_type>>(key) < num_buckets;
+    }
+
+    explicit BucketQueue(value_compare const &compare = value_compare()) : comp{compare}, buckets_(num_buckets) {
+    }
+
+    template <typename InputIt>
+    BucketQueue(InputIt first, InputIt last, value_compare const &compare = value_compare())
+        : comp{compare}, buckets_(num_buckets) {
+        push_range(first, last);
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr size_type size() const noexcept {
+        return size_;
+    }
+
+    constexpr const_reference top() const {
+        assert(!empty());
+        return buckets_[top_bucket_].back();
+    }
+
+    void pop() {
+        assert(!empty());
+        auto &bucket = buckets_[top_bucket_];
+        bucket.pop_back();
+        --size_;
+        if (bucket.empty()) {
+            reset(top_bucket_);
+            top_bucket_ = find_first(top_bucket_ + 1);
+        }
+    }
+
+    // Removes the top element and returns it by moving it out of the queue
+    value_type extract_top() {
+        assert(!empty());
+        value_type value = std::move(buckets_[top_bucket_].back());
+        pop();
+        return value;
+    }
+
+    void push(const_reference value) {
+        insert(value);
+    }
+
+    void push(value_type &&value) {
+        insert(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template <typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    void clear() noexcept {
+        for (auto b = find_first(0); b != num_buckets; b = find_first(b + 1)) {
+            buckets_[b].clear();
+        }
+        words_.fill(0);
+        summary_.fill(0);
+        top_bucket_ = num_buckets;
+        size_ = 0;
+    }
+
+    // The buckets grow on demand, since the distribution of the keys is not known in advance
+    void reserve(size_type /*new_cap*/) noexcept {
+    }
+
+    constexpr value_compare value_comp() const {
+        return comp;
+    }
+};
+
+}  // namespace multiqueue
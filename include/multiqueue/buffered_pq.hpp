@@ -10,18 +10,210 @@
 
 #pragma once
 
+#include "multiqueue/utils.hpp"
+
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace multiqueue {
 
-template <typename PriorityQueue, std::size_t insertion_buffer_size = 16, std::size_t deletion_buffer_size = 16>
+namespace detail {
+
+// `std::priority_queue` has neither `extract_top` nor `reserve`, but exposes its container
+template <typename PriorityQueue, typename = void>
+struct has_extract_top : std::false_type {};
+
+template <typename PriorityQueue>
+struct has_extract_top<PriorityQueue, std::void_t<decltype(std::declval<PriorityQueue&>().extract_top())>>
+    : std::true_type {};
+
+template <typename PriorityQueue, typename = void>
+struct has_reserve : std::false_type {};
+
+template <typename PriorityQueue>
+struct has_reserve<PriorityQueue, std::void_t<decltype(std::declval<PriorityQueue&>().reserve(std::size_t{}))>>
+    : std::true_type {};
+
+template <typename T, typename Compare>
+void compare_exchange(T& lhs, T& rhs, Compare const& comp) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        // Selects instead of branching, since the outcome is unpredictable
+        T const l = lhs;
+        T const r = rhs;
+        bool const swap = comp(r, l);
+        lhs = swap ? r : l;
+        rhs = swap ? l : r;
+    } else if (comp(rhs, lhs)) {
+        std::swap(lhs, rhs);
+    }
+}
+
+// Sorts the `N` values such that no value compares less than a value before it. The comparisons form Batcher's
+// merge-exchange network (Knuth, TAOCP Vol. 3, Algorithm 5.2.2M), so the sequence of compare-exchange operations is
+// fixed at compile time and the loops can be fully unrolled.
+template <std::size_t N, typename T, typename Compare>
+void sort_network(T* values, Compare const& comp) {
+    if constexpr (N > 1) {
+        std::size_t t = 0;
+        while ((std::size_t{1} << t) < N) {
+            ++t;
+        }
+        for (std::size_t p = std::size_t{1} << (t - 1); p > 0; p /= 2) {
+            std::size_t q = std::size_t{1} << (t - 1);
+            std::size_t r = 0;
+            std::size_t d = p;
+            while (true) {
+                for (std::size_t i = 0; i + d < N; ++i) {
+                    if ((i & p) == r) {
+                        compare_exchange(values[i], values[i + d], comp);
+                    }
+                }
+                if (q == p) {
+                    break;
+                }
+                d = q - p;
+                q /= 2;
+                r = p;
+            }
+        }
+    }
+}
+
+}  // namespace detail
+
+struct DefaultBufferedPQOptions {
+    // Adapt the capacities of the buffers to the ratio of pushes and pops, see `AdaptiveBufferedPQOptions`
+    static constexpr bool adaptive = false;
+};
+
+// The buffer sizes of the `BufferedPQ` are the maximum capacities. If pushes dominate, a larger insertion buffer
+// amortizes flushing it into the heap, while a smaller deletion buffer is cheaper to insert into. If pops dominate, a
+// larger deletion buffer amortizes refilling it. Balanced workloads leave the capacities unchanged.
+struct AdaptiveBufferedPQOptions {
+    static constexpr bool adaptive = true;
+    static constexpr std::size_t min_buffer_size = 4;
+    static constexpr std::size_t initial_buffer_size = 16;
+    // The counts of pushes and pops are halved once their sum reaches this, so that the ratio follows phase changes
+    static constexpr std::uint32_t window = 256;
+};
+
+namespace detail {
+
+template <std::size_t insertion_buffer_size, std::size_t deletion_buffer_size, typename Options,
+          bool = Options::adaptive>
+class BufferCapacity {
+   public:
+    static constexpr std::size_t insertion() noexcept {
+        return insertion_buffer_size;
+    }
+
+    static constexpr std::size_t deletion() noexcept {
+        return deletion_buffer_size;
+    }
+
+    void pushed() noexcept {
+    }
+
+    void popped() noexcept {
+    }
+
+    void adapt_insertion() noexcept {
+    }
+
+    void adapt_deletion() noexcept {
+    }
+};
+
+// Capacities are only changed while the respective buffer is empty
+template <std::size_t insertion_buffer_size, std::size_t deletion_buffer_size, typename Options>
+class BufferCapacity<insertion_buffer_size, deletion_buffer_size, Options, true> {
+    static constexpr std::size_t min_capacity(std::size_t max) noexcept {
+        return std::min(Options::min_buffer_size, max);
+    }
+
+    static constexpr std::size_t initial_capacity(std::size_t max) noexcept {
+        return std::clamp(Options::initial_buffer_size, min_capacity(max), max);
+    }
+
+    std::size_t insertion_{initial_capacity(insertion_buffer_size)};
+    std::size_t deletion_{initial_capacity(deletion_buffer_size)};
+    std::uint32_t pushes_{0};
+    std::uint32_t pops_{0};
+
+    void decay() noexcept {
+        if (pushes_ + pops_ >= Options::window) {
+            pushes_ /= 2;
+            pops_ /= 2;
+        }
+    }
+
+    [[nodiscard]] bool push_heavy() const noexcept {
+        return pushes_ > 2 * pops_;
+    }
+
+    [[nodiscard]] bool pop_heavy() const noexcept {
+        return pops_ > 2 * pushes_;
+    }
+
+    static std::size_t grow(std::size_t capacity, std::size_t max) noexcept {
+        return std::min(2 * capacity, max);
+    }
+
+    static std::size_t shrink(std::size_t capacity, std::size_t max) noexcept {
+        return std::max(capacity / 2, min_capacity(max));
+    }
+
+   public:
+    [[nodiscard]] std::size_t insertion() const noexcept {
+        return insertion_;
+    }
+
+    [[nodiscard]] std::size_t deletion() const noexcept {
+        return deletion_;
+    }
+
+    void pushed() noexcept {
+        ++pushes_;
+        decay();
+    }
+
+    void popped() noexcept {
+        ++pops_;
+        decay();
+    }
+
+    void adapt_insertion() noexcept {
+        if (push_heavy()) {
+            insertion_ = grow(insertion_, insertion_buffer_size);
+        } else if (pop_heavy()) {
+            insertion_ = shrink(insertion_, insertion_buffer_size);
+        }
+    }
+
+    void adapt_deletion() noexcept {
+        if (pop_heavy()) {
+            deletion_ = grow(deletion_, deletion_buffer_size);
+        } else if (push_heavy()) {
+            deletion_ = shrink(deletion_, deletion_buffer_size);
+        }
+    }
+};
+
+}  // namespace detail
+
+// Buffers the best values of the priority queue in a sorted deletion buffer and new values in an unsorted insertion
+// buffer. The buffer sizes are compile-time capacities, which the options can make adaptive at runtime.
+template <typename PriorityQueue, std::size_t insertion_buffer_size = 16, std::size_t deletion_buffer_size = 16,
+          typename Options = DefaultBufferedPQOptions>
 class BufferedPQ : private PriorityQueue {
     static_assert(insertion_buffer_size > 0 && deletion_buffer_size > 0, "Both buffers must have nonzero size");
     using base_type = PriorityQueue;
@@ -42,24 +234,134 @@ class BufferedPQ : private PriorityQueue {
     insertion_buffer_type insertion_buffer_;
     size_type deletion_end_ = 0;
     deletion_buffer_type deletion_buffer_;
+    [[no_unique_address]] detail::BufferCapacity<insertion_buffer_size, deletion_buffer_size, Options> capacity_;
+
+    value_type extract_base_top() {
+        if constexpr (detail::has_extract_top<base_type>::value) {
+            return base_type::extract_top();
+        } else {
+            value_type value = std::move(base_type::c.front());
+            base_type::pop();
+            return value;
+        }
+    }
 
     void flush_insertion_buffer() {
         for (; insertion_end_ != 0; --insertion_end_) {
             base_type::push(std::move(insertion_buffer_[insertion_end_ - 1]));
         }
+        capacity_.adapt_insertion();
+    }
+
+    // Sorts the values in [first, insertion_end_) of the insertion buffer with the best value at the back
+    void sort_insertion_buffer(size_type first) {
+        if (first == 0 && insertion_end_ == insertion_buffer_size) {
+            detail::sort_network<insertion_buffer_size>(insertion_buffer_.data(), base_type::comp);
+        } else {
+            std::sort(insertion_buffer_.begin() + first, insertion_buffer_.begin() + insertion_end_, base_type::comp);
+        }
     }
 
+    // Refills the deletion buffer from the heap and merges in the values of the insertion buffer that are better than
+    // the worst value taken from the heap. The values not taken into the deletion buffer stay in the insertion buffer,
+    // so the insertion buffer is never pushed into the heap during a refill.
     void refill_deletion_buffer() {
         assert(deletion_end_ == 0);
-        // We flush the insertion buffer into the heap, then refill the
-        // deletion buffer from the heap. We could also merge the insertion
-        // buffer and heap into the deletion buffer
-        flush_insertion_buffer();
-        size_type front_slot = std::min(deletion_buffer_size, base_type::size());
+        capacity_.adapt_deletion();
+        size_type front_slot = std::min(capacity_.deletion(), base_type::size());
         deletion_end_ = front_slot;
         while (front_slot != 0) {
-            deletion_buffer_[--front_slot] = std::move(base_type::c.front());
-            base_type::pop();
+            deletion_buffer_[--front_slot] = extract_base_top();
+        }
+        auto const candidates_begin = static_cast<size_type>(
+            std::partition(insertion_buffer_.begin(), insertion_buffer_.begin() + insertion_end_,
+                           [this](value_type const& value) {
+                               return deletion_end_ == capacity_.deletion() &&
+                                      !base_type::comp(deletion_buffer_[0], value);
+                           }) -
+            insertion_buffer_.begin());
+        if (candidates_begin == insertion_end_) {
+            return;
+        }
+        sort_insertion_buffer(candidates_begin);
+        // Merge both buffers from their best values into the deletion buffer and move the remaining values of the
+        // deletion buffer into the insertion buffer slots freed by the merge. The merged values are move constructed
+        // into raw storage, so that no values are default constructed while the queue is locked.
+        alignas(value_type) unsigned char merged_storage[sizeof(value_type) * deletion_buffer_size];
+        auto* const merged = reinterpret_cast<value_type*>(merged_storage);
+        auto const merged_end = std::min(capacity_.deletion(), deletion_end_ + insertion_end_ - candidates_begin);
+        size_type deletion_slot = deletion_end_;
+        size_type insertion_slot = insertion_end_;
+        for (size_type slot = merged_end; slot != 0;) {
+            if (insertion_slot != candidates_begin &&
+                (deletion_slot == 0 ||
+                 !base_type::comp(insertion_buffer_[insertion_slot - 1], deletion_buffer_[deletion_slot - 1]))) {
+                ::new (static_cast<void*>(merged + --slot)) value_type(std::move(insertion_buffer_[--insertion_slot]));
+            } else {
+                ::new (static_cast<void*>(merged + --slot)) value_type(std::move(deletion_buffer_[--deletion_slot]));
+            }
+        }
+        std::move(deletion_buffer_.begin(), deletion_buffer_.begin() + deletion_slot,
+                  insertion_buffer_.begin() + insertion_slot);
+        insertion_end_ = insertion_slot + deletion_slot;
+        std::move(merged, merged + merged_end, deletion_buffer_.begin());
+        std::destroy(merged, merged + merged_end);
+        deletion_end_ = merged_end;
+    }
+
+    // Returns the slot of the last value in the deletion buffer that `value` is not worse than. The deletion buffer
+    // must be nonempty and `value` must not be worse than its first value.
+    size_type insertion_slot(value_type const& value) const {
+        if constexpr (std::is_arithmetic_v<value_type> && utils::is_min_max_compare<value_type, value_compare>::value) {
+            // Counting the better values without an early exit lets the compiler vectorize the comparisons
+            size_type num_better = 0;
+            for (size_type i = 0; i < deletion_end_; ++i) {
+                num_better += static_cast<size_type>(base_type::comp(value, deletion_buffer_[i]));
+            }
+            return deletion_end_ - 1 - num_better;
+        } else {
+            size_type slot = deletion_end_ - 1;
+            while (base_type::comp(value, deletion_buffer_[slot])) {
+                --slot;
+            }
+            return slot;
+        }
+    }
+
+    template <typename V>
+    void insert(V&& value) {
+        capacity_.pushed();
+        if (deletion_end_ > 0 && !base_type::comp(value, deletion_buffer_[0])) {
+            size_type const slot = insertion_slot(value);
+            if (deletion_end_ == capacity_.deletion()) {
+                if (insertion_end_ == capacity_.insertion()) {
+                    flush_insertion_buffer();
+                    base_type::push(std::move(deletion_buffer_[0]));
+                } else {
+                    insertion_buffer_[insertion_end_++] = std::move(deletion_buffer_[0]);
+                }
+                std::move(deletion_buffer_.begin() + 1, deletion_buffer_.begin() + slot + 1, deletion_buffer_.begin());
+                deletion_buffer_[slot] = std::forward<V>(value);
+            } else {
+                std::move_backward(deletion_buffer_.begin() + slot + 1, deletion_buffer_.begin() + deletion_end_,
+                                   deletion_buffer_.begin() + deletion_end_ + 1);
+                deletion_buffer_[slot + 1] = std::forward<V>(value);
+                ++deletion_end_;
+            }
+            return;
+        }
+        if (deletion_end_ < capacity_.deletion() && base_type::size() == 0 && insertion_end_ == 0) {
+            std::move_backward(deletion_buffer_.begin(), deletion_buffer_.begin() + deletion_end_,
+                               deletion_buffer_.begin() + deletion_end_ + 1);
+            deletion_buffer_[0] = std::forward<V>(value);
+            ++deletion_end_;
+            return;
+        }
+        if (insertion_end_ == capacity_.insertion()) {
+            flush_insertion_buffer();
+            base_type::push(std::forward<V>(value));
+        } else {
+            insertion_buffer_[insertion_end_++] = std::forward<V>(value);
         }
     }
 
@@ -91,57 +393,75 @@ class BufferedPQ : private PriorityQueue {
 
     void pop() {
         assert(!empty());
+        capacity_.popped();
         --deletion_end_;
         if (deletion_end_ == 0) {
             refill_deletion_buffer();
         }
     }
 
-    void push(const_reference value) {
-        if (deletion_end_ > 0 && !base_type::comp(value, deletion_buffer_[0])) {
-            size_type slot = deletion_end_ - 1;
-            while (base_type::comp(value, deletion_buffer_[slot])) {
-                --slot;
-            }
-            if (deletion_end_ == deletion_buffer_size) {
-                if (insertion_end_ == insertion_buffer_size) {
-                    flush_insertion_buffer();
-                    base_type::push(std::move(deletion_buffer_[0]));
-                } else {
-                    insertion_buffer_[insertion_end_++] = std::move(deletion_buffer_[0]);
-                }
-                std::move(deletion_buffer_.begin() + 1, deletion_buffer_.begin() + slot + 1, deletion_buffer_.begin());
-                deletion_buffer_[slot] = value;
-            } else {
-                std::move_backward(deletion_buffer_.begin() + slot + 1, deletion_buffer_.begin() + deletion_end_,
-                                   deletion_buffer_.begin() + deletion_end_ + 1);
-                deletion_buffer_[slot + 1] = value;
-                ++deletion_end_;
-            }
-            return;
-        }
-        if (deletion_end_ < deletion_buffer_size && base_type::size() == 0 && insertion_end_ == 0) {
-            std::move_backward(deletion_buffer_.begin(), deletion_buffer_.begin() + deletion_end_,
-                               deletion_buffer_.begin() + deletion_end_ + 1);
-            deletion_buffer_[0] = value;
-            ++deletion_end_;
-            return;
+    // Removes the top element and returns it by moving it out of the deletion buffer
+    value_type extract_top() {
+        assert(!empty());
+        capacity_.popped();
+        value_type value = std::move(deletion_buffer_[--deletion_end_]);
+        if (deletion_end_ == 0) {
+            refill_deletion_buffer();
         }
-        if (insertion_end_ == insertion_buffer_size) {
-            flush_insertion_buffer();
-            base_type::push(value);
+        return value;
+    }
+
+    void push(const_reference value) {
+        insert(value);
+    }
+
+    void push(value_type&& value) {
+        insert(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        insert(value_type(std::forward<Args>(args)...));
+    }
+
+    // Inserts all elements in [first, last) together with the values of the deletion buffer into the underlying
+    // priority queue, which can then use linear-time heap construction. The insertion buffer is kept as is, and its
+    // values are merged into the deletion buffer when it is refilled afterwards.
+    template <typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        base_type::push_range(first, last);
+        base_type::push_range(std::make_move_iterator(deletion_buffer_.begin()),
+                              std::make_move_iterator(deletion_buffer_.begin() + deletion_end_));
+        deletion_end_ = 0;
+        refill_deletion_buffer();
+    }
+
+    void clear() noexcept {
+        insertion_end_ = 0;
+        deletion_end_ = 0;
+        base_type::clear();
+    }
+
+    void reserve(size_type new_cap) {
+        if constexpr (detail::has_reserve<base_type>::value) {
+            base_type::reserve(new_cap);
         } else {
-            insertion_buffer_[insertion_end_++] = value;
+            base_type::c.reserve(new_cap);
         }
     }
 
-    void reserve(size_type new_cap) {
-        base_type::c.reserve(new_cap);
+    // The current capacities of the buffers
+    [[nodiscard]] size_type insertion_capacity() const noexcept {
+        return capacity_.insertion();
+    }
+
+    [[nodiscard]] size_type deletion_capacity() const noexcept {
+        return capacity_.deletion();
     }
 };
 
-template <typename PriorityQueue>
-class BufferedPQ<PriorityQueue, 0, 0> : private PriorityQueue {
+template <typename PriorityQueue, typename Options>
+class BufferedPQ<PriorityQueue, 0, 0, Options> : private PriorityQueue {
    private:
     using base_type = PriorityQueue;
 
@@ -167,7 +487,8 @@ class BufferedPQ<PriorityQueue, 0, 0> : private PriorityQueue {
         return base_type::size();
     }
 
-    constexpr const_reference top() const {
+    // The underlying priority queue might return a proxy
+    constexpr decltype(auto) top() const {
         assert(!empty());
         return base_type::top();
     }
@@ -177,20 +498,49 @@ class BufferedPQ<PriorityQueue, 0, 0> : private PriorityQueue {
         base_type::pop();
     }
 
+    value_type extract_top() {
+        assert(!empty());
+        return base_type::extract_top();
+    }
+
     void push(const_reference value) {
         base_type::push(value);
     }
 
+    void push(value_type&& value) {
+        base_type::push(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        base_type::emplace(std::forward<Args>(args)...);
+    }
+
+    template <typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        base_type::push_range(first, last);
+    }
+
+    void clear() noexcept {
+        base_type::clear();
+    }
+
     void reserve(size_type new_cap) {
-        base_type::c.reserve(new_cap);
+        if constexpr (detail::has_reserve<base_type>::value) {
+            base_type::reserve(new_cap);
+        } else {
+            base_type::c.reserve(new_cap);
+        }
     }
 };
 
 }  // namespace multiqueue
 
 namespace std {
-template <typename PriorityQueue, std::size_t insertion_buffer_size, std::size_t deletion_buffer_size, typename Alloc>
-struct uses_allocator<multiqueue::BufferedPQ<PriorityQueue, insertion_buffer_size, deletion_buffer_size>, Alloc>
+template <typename PriorityQueue, std::size_t insertion_buffer_size, std::size_t deletion_buffer_size, typename Options,
+          typename Alloc>
+struct uses_allocator<multiqueue::BufferedPQ<PriorityQueue, insertion_buffer_size, deletion_buffer_size, Options>,
+                      Alloc>
     : uses_allocator<PriorityQueue, Alloc>::type {};
 
 }  // namespace std
@@ -1,64 +1,264 @@
 #pragma once
 
+#include "multiqueue/size_counter.hpp"
+#include "multiqueue/stats.hpp"
+
 #include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <type_traits>
+#include <utility>
 
 namespace multiqueue {
 
 template <typename Context>
 class Handle : public Context::policy_type::mode_type {
     using mode_type = typename Context::policy_type::mode_type;
+    using stats_type = stats::Recorder<stats::is_enabled<typename Context::policy_type>::value>;
 
     Context *context_;
+    SizeCounter::Slot *size_slot_;
+    [[no_unique_address]] stats_type stats_;
+    // Different handles start scanning at different queues, so that they do not all contend on the same queues
+    std::size_t scan_start_;
     using value_type = typename Context::value_type;
 
+    // Calls `try_pq` on the queues marked nonempty, starting at a different queue each time, until it returns true.
+    // Returns false if no call returned true.
+    template <typename TryPQ>
+    bool for_each_nonempty(TryPQ &&try_pq) {
+        auto const &nonempty = context_->nonempty_pqs();
+        auto const num_pqs = context_->num_pqs();
+        auto const start = scan_start_++ & (num_pqs - 1);
+        for (auto i = nonempty.find_first(start, num_pqs); i != num_pqs; i = nonempty.find_first(i + 1, num_pqs)) {
+            if (try_pq(context_->pq_guards()[i])) {
+                return true;
+            }
+        }
+        for (auto i = nonempty.find_first(0, start); i != start; i = nonempty.find_first(i + 1, start)) {
+            if (try_pq(context_->pq_guards()[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Locks every queue and checks if it is empty. Queues that cannot be locked are considered nonempty.
+    bool all_empty() {
+        // Sleeping needs the check under the locks, but a queue marked nonempty saves locking all queues
+        if (context_->nonempty_pqs().any(context_->num_pqs())) {
+            return false;
+        }
+        for (auto *it = context_->pq_guards(); it != context_->pq_guards() + context_->num_pqs(); ++it) {
+            if (!it->try_lock()) {
+                return false;
+            }
+            bool empty = it->get_pq().empty();
+            it->unlock();
+            if (!empty) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void release() {
+        if (context_ != nullptr) {
+            context_->size_counter().release_slot(size_slot_);
+            context_->stats_registry().release(stats_);
+            context_->parking().deregister_handle();
+        }
+    }
+
    public:
-    explicit Handle(Context &ctx) noexcept : mode_type{ctx.config(), ctx.shared_data()}, context_{&ctx} {
+    explicit Handle(Context &ctx)
+        : mode_type{ctx.config(), ctx.shared_data()},
+          context_{&ctx},
+          size_slot_{ctx.size_counter().acquire_slot()},
+          stats_{ctx.stats_registry().acquire()},
+          scan_start_{ctx.next_handle_id() * 0x9e3779b97f4a7c15} {
+        context_->parking().register_handle();
     }
 
     Handle(Handle const &) = delete;
-    Handle(Handle &&) noexcept = default;
+
+    Handle(Handle &&other) noexcept
+        : mode_type(std::move(static_cast<mode_type &>(other))),
+          context_{std::exchange(other.context_, nullptr)},
+          size_slot_{std::exchange(other.size_slot_, nullptr)},
+          stats_{other.stats_},
+          scan_start_{other.scan_start_} {
+    }
+
     Handle &operator=(Handle const &) = delete;
-    Handle &operator=(Handle &&) noexcept = default;
-    ~Handle() = default;
+
+    Handle &operator=(Handle &&other) noexcept {
+        if (this != &other) {
+            release();
+            mode_type::operator=(std::move(static_cast<mode_type &>(other)));
+            context_ = std::exchange(other.context_, nullptr);
+            size_slot_ = std::exchange(other.size_slot_, nullptr);
+            stats_ = other.stats_;
+            scan_start_ = other.scan_start_;
+        }
+        return *this;
+    }
+
+    ~Handle() {
+        release();
+    }
 
     void push(value_type const &v) {
-        mode_type::push(*context_, v);
+        mode_type::push(*context_, stats_, v);
+        size_slot_->add(1);
+        stats_.pushed(1);
+        context_->parking().notify_one();
+    }
+
+    void push(value_type &&v) {
+        mode_type::push(*context_, stats_, std::move(v));
+        size_slot_->add(1);
+        stats_.pushed(1);
+        context_->parking().notify_one();
+    }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        mode_type::push(*context_, stats_, value_type(std::forward<Args>(args)...));
+        size_slot_->add(1);
+        stats_.pushed(1);
+        context_->parking().notify_one();
+    }
+
+    // Pushes all elements in [first, last). The mode may insert several elements into the same queue while holding
+    // its lock.
+    template <typename InputIt>
+    void push(InputIt first, InputIt last) {
+        auto const n = mode_type::push(*context_, stats_, first, last);
+        size_slot_->add(static_cast<std::int64_t>(n));
+        stats_.pushed(n);
+        context_->parking().notify_all();
     }
 
     std::optional<value_type> scan() {
-        for (auto *it = context_->pq_guards(); it != context_->pq_guards() + context_->num_pqs(); ++it) {
-            if (!it->try_lock()) {
-                continue;
+        std::optional<value_type> v;
+        for_each_nonempty([&](auto &guard) {
+            if (!guard.try_lock()) {
+                return false;
             }
-            if (it->get_pq().empty()) {
-                it->unlock();
-                continue;
+            if (guard.get_pq().empty()) {
+                guard.unlock();
+                return false;
             }
-            auto v = it->get_pq().top();
-            it->get_pq().pop();
-            it->popped();
-            it->unlock();
-            return v;
+            v = guard.get_pq().extract_top();
+            guard.popped();
+            guard.unlock();
+            return true;
+        });
+        if (v) {
+            size_slot_->add(-1);
+            stats_.popped(1);
         }
-        return std::nullopt;
+        return v;
+    }
+
+    // Pops up to `k` elements from a nonempty queue and returns the number of elements written to `out`
+    template <typename OutputIt>
+    std::size_t scan_n(OutputIt out, std::size_t k) {
+        std::size_t n = 0;
+        for_each_nonempty([&](auto &guard) {
+            if (!guard.try_lock()) {
+                return false;
+            }
+            if (guard.get_pq().empty()) {
+                guard.unlock();
+                return false;
+            }
+            do {
+                *out++ = guard.get_pq().extract_top();
+                ++n;
+            } while (n != k && !guard.get_pq().empty());
+            guard.popped();
+            guard.unlock();
+            return true;
+        });
+        size_slot_->add(-static_cast<std::int64_t>(n));
+        stats_.popped(n);
+        return n;
     }
 
     std::optional<value_type> try_pop() {
         for (int i = 0; i < Context::policy_type::pop_tries; ++i) {
-            std::optional<value_type> v = mode_type::try_pop(*context_);
+            std::optional<value_type> v = mode_type::try_pop(*context_, stats_);
             if (v) {
+                size_slot_->add(-1);
+                stats_.popped(1);
                 return v;
             }
         }
         if (!Context::policy_type::scan) {
             return std::nullopt;
         }
+        stats_.scan();
         return scan();
     }
+
+    // Pops up to `k` elements from a single queue and writes them to `out`. Returns the number of elements written,
+    // which is 0 only if no element could be found.
+    template <typename OutputIt>
+    std::size_t try_pop_n(OutputIt out, std::size_t k) {
+        if (k == 0) {
+            return 0;
+        }
+        for (int i = 0; i < Context::policy_type::pop_tries; ++i) {
+            std::size_t n = mode_type::try_pop_n(*context_, stats_, out, k);
+            if (n != 0) {
+                size_slot_->add(-static_cast<std::int64_t>(n));
+                stats_.popped(n);
+                return n;
+            }
+        }
+        if (!Context::policy_type::scan) {
+            return 0;
+        }
+        stats_.scan();
+        return scan_n(out, k);
+    }
+
+    // Blocks until an element could be popped. Returns std::nullopt only if the multiqueue is terminated, i.e. it is
+    // empty and all handles are blocked in `pop` or `pop_for`. Only handles that currently exist are counted, so the
+    // handles of all threads that may still push must be created before any handle blocks. A destroyed handle no
+    // longer counts, so a thread must not release its handle while it may still push.
+    std::optional<value_type> pop() {
+        while (true) {
+            if (auto v = try_pop(); v) {
+                return v;
+            }
+            if (!context_->parking().wait([this] { return all_empty(); })) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    // Same as `pop`, but also returns std::nullopt if no element could be popped within `timeout`
+    template <typename Rep, typename Period>
+    std::optional<value_type> pop_for(std::chrono::duration<Rep, Period> const &timeout) {
+        auto const deadline = std::chrono::steady_clock::now() + timeout;
+        while (true) {
+            if (auto v = try_pop(); v) {
+                return v;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return std::nullopt;
+            }
+            if (!context_->parking().wait_until([this] { return all_empty(); }, deadline)) {
+                return std::nullopt;
+            }
+        }
+    }
 };
 
 }  // namespace multiqueue
@@ -9,15 +9,119 @@
 **/
 #pragma once
 
+#include "multiqueue/build_config.hpp"
+#include "multiqueue/utils.hpp"
+
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace multiqueue {
 
-template <typename T, typename Compare = std::less<>, unsigned int arity = 8, typename Container = std::vector<T>>
+namespace detail {
+
+// For floating point values compared by min or max, the best of several children is found without branches by
+// reducing the children pairwise, which the compiler vectorizes. Integral values are not reduced, since the compiler
+// already selects the best child with conditional moves, which is faster.
+template <typename T, typename Compare, unsigned int arity>
+inline constexpr bool branchless_children_v = std::is_floating_point_v<T> &&
+                                              utils::is_min_max_compare<T, Compare>::value &&
+                                              (arity & (arity - 1)) == 0 && arity <= 64;
+
+// Returns the offset of the first best element among the `arity` elements starting at `children`
+template <unsigned int arity, typename T, typename Compare>
+std::size_t best_child(T const *children, Compare const &comp) {
+    if constexpr (branchless_children_v<T, Compare, arity>) {
+        T best[arity];
+        for (unsigned int i = 0; i < arity; ++i) {
+            best[i] = children[i];
+        }
+        for (unsigned int width = arity / 2; width > 0; width /= 2) {
+            for (unsigned int i = 0; i < width; ++i) {
+                best[i] = comp(best[i], best[i + width]) ? best[i + width] : best[i];
+            }
+        }
+        std::uint64_t mask = 0;
+        for (unsigned int i = 0; i < arity; ++i) {
+            mask |= static_cast<std::uint64_t>(children[i] == best[0]) << i;
+        }
+        // The mask is only zero for NaN, in which case the scalar loop decides
+        if (mask != 0) {
+            return static_cast<std::size_t>(__builtin_ctzll(mask));
+        }
+    }
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < arity; ++i) {
+        if (comp(children[best], children[i])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+}  // namespace detail
+
+// Allocates storage aligned to a cache line, but returns a pointer to the element at index `padding`. With a padding
+// of `arity - 1` elements, the children of every node in a d-ary heap start on a cache line if `arity * sizeof(T)` is
+// a multiple of the cache line size.
+template <typename T, std::size_t padding = 0>
+class CacheAlignedAllocator {
+    static constexpr std::size_t alignment = std::max(build_config::l1_cache_line_size, alignof(T));
+
+   public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = CacheAlignedAllocator<U, padding>;
+    };
+
+    CacheAlignedAllocator() noexcept = default;
+
+    // Not explicit, like the converting constructor of std::allocator
+    template <typename U>
+    CacheAlignedAllocator(CacheAlignedAllocator<U, padding> const & /*other*/) noexcept {
+    }
+
+    [[nodiscard]] T *allocate(std::size_t n) {
+        return static_cast<T *>(::operator new((n + padding) * sizeof(T), std::align_val_t{alignment})) + padding;
+    }
+
+    void deallocate(T *p, std::size_t /*n*/) noexcept {
+        ::operator delete(p - padding, std::align_val_t{alignment});
+    }
+
+    friend bool operator==(CacheAlignedAllocator const & /*lhs*/, CacheAlignedAllocator const & /*rhs*/) noexcept {
+        return true;
+    }
+
+    friend bool operator!=(CacheAlignedAllocator const & /*lhs*/, CacheAlignedAllocator const & /*rhs*/) noexcept {
+        return false;
+    }
+};
+
+// Options of how `Heap` sifts down after a pop. Options are changed by deriving from this struct and hiding members.
+struct DefaultHeapOptions {
+    // Prefetch the grandchildren of a node while selecting the best of its children
+    static constexpr bool prefetch = false;
+    // Move the hole left by the top element down to a leaf along the best children without comparing them to the last
+    // element, then sift the last element up from the leaf. Saves comparisons if the last element belongs near the
+    // leaves, as it usually does.
+    static constexpr bool bottom_up = false;
+};
+
+struct AlignedHeapOptions : DefaultHeapOptions {
+    static constexpr bool prefetch = true;
+};
+
+template <typename T, typename Compare = std::less<>, unsigned int arity = 8, typename Container = std::vector<T>,
+          typename Options = DefaultHeapOptions>
 class Heap {
     static_assert(arity >= 2, "Arity must be at least two");
 
@@ -48,6 +152,24 @@ class Heap {
         return index * arity + size_type(1);
     }
 
+    // Returns the offset of the first best child among the `arity` children starting at `first`
+    size_type best_child(size_type first) const {
+        return static_cast<size_type>(detail::best_child<arity>(&c[first], comp));
+    }
+
+    // The grandchildren of a node are stored contiguously, starting at the first child of its first child
+    void prefetch_grandchildren(size_type first) const {
+        auto const grandchildren = first_child(first);
+        if (grandchildren >= size()) {
+            return;
+        }
+        auto const *begin = reinterpret_cast<char const *>(&c[grandchildren]);
+        auto const bytes = std::min(size() - grandchildren, size_type{arity} * arity) * sizeof(T);
+        for (std::size_t offset = 0; offset < bytes; offset += build_config::l1_cache_line_size) {
+            __builtin_prefetch(begin + offset);
+        }
+    }
+
     // Find the index of the node that should become the parent of the others
     // If no index is better than the last element, return last
     size_type new_parent(size_type first, size_type last) const {
@@ -62,8 +184,7 @@ class Heap {
         return best;
     }
 
-    void sift_up() {
-        size_type index = size() - 1;
+    void sift_up(size_type index) {
         if (index == root) {
             return;
         }
@@ -80,18 +201,62 @@ class Heap {
         c[index] = std::move(value);
     }
 
+    // Replaces the top element with the last element, see `DefaultHeapOptions::bottom_up`
+    void sift_down_bottom_up() {
+        assert(!empty());
+        auto const last = size() - 1;
+        size_type index = root;
+        while (true) {
+            auto const first = first_child(index);
+            if (first >= last) {
+                break;
+            }
+            if constexpr (Options::prefetch) {
+                prefetch_grandchildren(first);
+            }
+            auto next = first;
+            if (first + arity <= last) {
+                next += best_child(first);
+            } else {
+                for (auto i = first + 1; i < last; ++i) {
+                    if (comp(c[next], c[i])) {
+                        next = i;
+                    }
+                }
+            }
+            c[index] = std::move(c[next]);
+            index = next;
+        }
+        value_type value = std::move(c[last]);
+        while (index != root) {
+            auto const p = parent(index);
+            if (!comp(c[p], value)) {
+                break;
+            }
+            c[index] = std::move(c[p]);
+            index = p;
+        }
+        c[index] = std::move(value);
+    }
+
     void sift_down() {
         assert(!empty());
         if (size() == 1) {
             return;
         }
+        if constexpr (Options::bottom_up) {
+            sift_down_bottom_up();
+            return;
+        }
         size_type const end_full = parent(size() - 1);
         size_type index = 0;
         while (index < end_full) {
             auto const first = first_child(index);
-            auto const last = first + arity;
-            auto const next = new_parent(first, last);
-            if (next == size() - 1) {
+            if constexpr (Options::prefetch) {
+                prefetch_grandchildren(first);
+            }
+            auto const next = first + best_child(first);
+            if (!comp(c[size() - 1], c[next])) {
                 c[index] = std::move(c[size() - 1]);
                 return;
             }
@@ -112,6 +277,43 @@ class Heap {
         c[index] = std::move(c[size() - 1]);
     }
 
+    // Moves the element at `index` down until its subtree satisfies the heap property
+    void sift_down(size_type index) {
+        value_type value = std::move(c[index]);
+        while (true) {
+            auto const first = first_child(index);
+            if (first >= size()) {
+                break;
+            }
+            auto best = first;
+            if (first + arity <= size()) {
+                best += best_child(first);
+            } else {
+                for (auto i = first + 1; i < size(); ++i) {
+                    if (comp(c[best], c[i])) {
+                        best = i;
+                    }
+                }
+            }
+            if (!comp(value, c[best])) {
+                break;
+            }
+            c[index] = std::move(c[best]);
+            index = best;
+        }
+        c[index] = std::move(value);
+    }
+
+    // Bottom-up heap construction in linear time
+    void make_heap() {
+        if (size() < 2) {
+            return;
+        }
+        for (size_type index = parent(size() - 1) + 1; index-- != root;) {
+            sift_down(index);
+        }
+    }
+
    public:
     explicit Heap(value_compare const &compare = value_compare()) noexcept(noexcept(Container())) : c(), comp{compare} {
     }
@@ -124,6 +326,11 @@ class Heap {
     explicit Heap(Alloc const &alloc) noexcept : c(alloc), comp() {
     }
 
+    template <typename InputIt>
+    Heap(InputIt first, InputIt last, value_compare const &compare = value_compare()) : c(first, last), comp{compare} {
+        make_heap();
+    }
+
     [[nodiscard]] constexpr bool empty() const noexcept {
         return c.empty();
     }
@@ -142,36 +349,69 @@ class Heap {
         c.pop_back();
     }
 
+    // Removes the top element and returns it by moving it out of the heap
+    value_type extract_top() {
+        assert(!empty());
+        value_type value = std::move(c.front());
+        pop();
+        return value;
+    }
+
     void push(const_reference value) {
         c.push_back(value);
-        sift_up();
+        sift_up(size() - 1);
     }
 
     void push(value_type &&value) {
         c.push_back(std::move(value));
-        sift_up();
+        sift_up(size() - 1);
     }
 
     template <typename... Args>
     void emplace(Args &&...args) {
         c.emplace_back(std::forward<Args>(args)...);
-        sift_up();
+        sift_up(size() - 1);
+    }
+
+    // Inserts all elements in [first, last). If the range is at least as large as the heap, the heap is rebuilt in
+    // linear time, otherwise the elements are sifted up one by one.
+    template <typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        auto const old_size = size();
+        c.insert(c.end(), first, last);
+        if (size() - old_size >= old_size) {
+            make_heap();
+        } else {
+            for (auto index = old_size; index != size(); ++index) {
+                sift_up(index);
+            }
+        }
     }
 
     constexpr void clear() noexcept {
         c.clear();
     }
 
+    void reserve(size_type new_cap) {
+        c.reserve(new_cap);
+    }
+
     constexpr value_compare value_comp() const {
         return comp;
     }
 };
 
+// Heap whose sibling groups start on a cache line and which prefetches the grandchildren while popping. Meant for
+// heaps too large for the cache, with `arity * sizeof(T)` a multiple of the cache line size.
+template <typename T, typename Compare = std::less<>, unsigned int arity = 8>
+using AlignedHeap =
+    Heap<T, Compare, arity, std::vector<T, CacheAlignedAllocator<T, arity - 1>>, AlignedHeapOptions>;
+
 }  // namespace multiqueue
 
 namespace std {
-template <typename T, typename Compare, unsigned int arity, typename Container, typename Alloc>
-struct uses_allocator<multiqueue::Heap<T, Compare, arity, Container>, Alloc> : uses_allocator<Container, Alloc>::type {
-};
+template <typename T, typename Compare, unsigned int arity, typename Container, typename Options, typename Alloc>
+struct uses_allocator<multiqueue::Heap<T, Compare, arity, Container, Options>, Alloc>
+    : uses_allocator<Container, Alloc>::type {};
 
 }  // namespace std
@@ -0,0 +1,272 @@
+/**
+******************************************************************************
+* @file:   key_value_heap.hpp
+*
+* @brief:  d-ary heap of key-value pairs with the keys and the mapped values
+*          stored in separate arrays
+*******************************************************************************
+**/
+#pragma once
+
+#include "multiqueue/heap.hpp"
+#include "multiqueue/utils.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace multiqueue {
+
+// Behaves like a `Heap` of `std::pair<Key, T>` ordered by the keys, but only the keys are compared and moved while
+// sifting. The mapped values are moved along the final path once a sift is finished, so that large mapped values do
+// not pollute the cache lines of the keys. Since the pairs are not stored, `top` returns a pair of references.
+template <typename Key, typename T, typename Compare = std::less<>, unsigned int arity = 8,
+          typename KeyContainer = std::vector<Key>, typename MappedContainer = std::vector<T>>
+class KeyValueHeap {
+    static_assert(arity >= 2, "Arity must be at least two");
+
+   public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using key_compare = Compare;
+    using value_compare = utils::ValueCompare<value_type, utils::PairFirst, Compare>;
+    using reference = value_type &;
+    using const_reference = value_type const &;
+    using top_type = std::pair<key_type const &, mapped_type const &>;
+
+    using size_type = typename KeyContainer::size_type;
+
+   protected:
+    // NOLINTNEXTLINE(cppcoreguidelines-non-private-member-variables-in-classes): Compatibility to Heap
+    [[no_unique_address]] value_compare comp;
+
+   private:
+    static constexpr size_type root = size_type{0};
+    // The length of the longest path from the root to a leaf
+    static constexpr std::size_t max_depth = std::numeric_limits<size_type>::digits;
+
+    KeyContainer keys_;
+    MappedContainer mapped_;
+
+    static constexpr size_type parent(size_type index) {
+        assert(index != root);
+        return (index - size_type(1)) / arity;
+    }
+
+    static constexpr size_type first_child(size_type index) noexcept {
+        return index * arity + size_type(1);
+    }
+
+    [[nodiscard]] bool key_less(key_type const &lhs, key_type const &rhs) const {
+        return comp.key_comp(lhs, rhs);
+    }
+
+    // Moves the best children up, starting at `index`, as long as their keys are better than `key`. Only the first
+    // `end` elements are considered. Stores the indices of the moved children in `path` and returns the index of the
+    // resulting hole.
+    size_type sift_down_keys(size_type index, key_type const &key, size_type end, size_type *path,
+                             std::size_t &depth) {
+        depth = 0;
+        while (true) {
+            auto const first = first_child(index);
+            if (first >= end) {
+                break;
+            }
+            auto best = first;
+            if (first + arity <= end) {
+                best += static_cast<size_type>(detail::best_child<arity>(&keys_[first], comp.key_comp));
+            } else {
+                for (auto i = first + 1; i < end; ++i) {
+                    if (key_less(keys_[best], keys_[i])) {
+                        best = i;
+                    }
+                }
+            }
+            if (!key_less(key, keys_[best])) {
+                break;
+            }
+            keys_[index] = std::move(keys_[best]);
+            path[depth++] = best;
+            index = best;
+        }
+        return index;
+    }
+
+    // Moves the mapped values on `path` up by one and places `mapped` at the end of the path
+    void shift_mapped(size_type index, size_type const *path, std::size_t depth, mapped_type &&mapped) {
+        for (std::size_t i = 0; i < depth; ++i) {
+            mapped_[index] = std::move(mapped_[path[i]]);
+            index = path[i];
+        }
+        mapped_[index] = std::move(mapped);
+    }
+
+    void sift_up(size_type index) {
+        if (index == root) {
+            return;
+        }
+        key_type key = std::move(keys_[index]);
+        size_type hole = index;
+        while (hole != root) {
+            auto const p = parent(hole);
+            if (!key_less(keys_[p], key)) {
+                break;
+            }
+            keys_[hole] = std::move(keys_[p]);
+            hole = p;
+        }
+        keys_[hole] = std::move(key);
+        if (hole == index) {
+            return;
+        }
+        mapped_type mapped = std::move(mapped_[index]);
+        for (auto i = index; i != hole; i = parent(i)) {
+            mapped_[i] = std::move(mapped_[parent(i)]);
+        }
+        mapped_[hole] = std::move(mapped);
+    }
+
+    // Replaces the root with the last element and restores the heap property, excluding the last element
+    void sift_down() {
+        assert(!empty());
+        auto const last = size() - 1;
+        if (last == root) {
+            return;
+        }
+        size_type path[max_depth];
+        std::size_t depth = 0;
+        auto const hole = sift_down_keys(root, keys_[last], last, path, depth);
+        keys_[hole] = std::move(keys_[last]);
+        shift_mapped(root, path, depth, std::move(mapped_[last]));
+    }
+
+    // Moves the element at `index` down until its subtree satisfies the heap property
+    void sift_down(size_type index) {
+        key_type key = std::move(keys_[index]);
+        size_type path[max_depth];
+        std::size_t depth = 0;
+        auto const hole = sift_down_keys(index, key, size(), path, depth);
+        keys_[hole] = std::move(key);
+        if (depth != 0) {
+            mapped_type mapped = std::move(mapped_[index]);
+            shift_mapped(index, path, depth, std::move(mapped));
+        }
+    }
+
+    // Bottom-up heap construction in linear time
+    void make_heap() {
+        if (size() < 2) {
+            return;
+        }
+        for (size_type index = parent(size() - 1) + 1; index-- != root;) {
+            sift_down(index);
+        }
+    }
+
+    template <typename K, typename M>
+    void append(K &&key, M &&mapped) {
+        keys_.push_back(std::forward<K>(key));
+        mapped_.push_back(std::forward<M>(mapped));
+    }
+
+   public:
+    explicit KeyValueHeap(value_compare const &compare = value_compare()) : comp{compare} {
+    }
+
+    template <typename InputIt>
+    KeyValueHeap(InputIt first, InputIt last, value_compare const &compare = value_compare()) : comp{compare} {
+        push_range(first, last);
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return keys_.empty();
+    }
+
+    constexpr size_type size() const noexcept {
+        return keys_.size();
+    }
+
+    constexpr top_type top() const {
+        assert(!empty());
+        return {keys_.front(), mapped_.front()};
+    }
+
+    void pop() {
+        assert(!empty());
+        sift_down();
+        keys_.pop_back();
+        mapped_.pop_back();
+    }
+
+    // Removes the top element and returns it by moving it out of the heap
+    value_type extract_top() {
+        assert(!empty());
+        value_type value{std::move(keys_.front()), std::move(mapped_.front())};
+        pop();
+        return value;
+    }
+
+    void push(const_reference value) {
+        append(value.first, value.second);
+        sift_up(size() - 1);
+    }
+
+    void push(value_type &&value) {
+        append(std::move(value.first), std::move(value.second));
+        sift_up(size() - 1);
+    }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        push(value_type(std::forward<Args>(args)...));
+    }
+
+    // Constructs the key and the mapped value in place
+    template <typename K, typename M>
+    void emplace(K &&key, M &&mapped) {
+        append(std::forward<K>(key), std::forward<M>(mapped));
+        sift_up(size() - 1);
+    }
+
+    // Inserts all elements in [first, last). If the range is at least as large as the heap, the heap is rebuilt in
+    // linear time, otherwise the elements are sifted up one by one.
+    template <typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        auto const old_size = size();
+        for (; first != last; ++first) {
+            auto &&value = *first;
+            append(std::forward<decltype(value)>(value).first, std::forward<decltype(value)>(value).second);
+        }
+        if (size() - old_size >= old_size) {
+            make_heap();
+        } else {
+            for (auto index = old_size; index != size(); ++index) {
+                sift_up(index);
+            }
+        }
+    }
+
+    constexpr void clear() noexcept {
+        keys_.clear();
+        mapped_.clear();
+    }
+
+    void reserve(size_type new_cap) {
+        keys_.reserve(new_cap);
+        mapped_.reserve(new_cap);
+    }
+
+    constexpr value_compare value_comp() const {
+        return comp;
+    }
+
+    constexpr key_compare key_comp() const {
+        return comp.key_comp;
+    }
+};
+
+}  // namespace multiqueue
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "multiqueue/topology.hpp"
+
+#include "pcg_random.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace multiqueue::mode {
+
+// Groups the queues by the cache domains of the cpus, i.e. the cpus sharing a cache of level `cache_level`. Handles
+// push into the group of the domain they were created on. Pops compare one candidate from the local group with one
+// candidate from all queues, so that most accesses to guards and heaps stay within the domain, while the global
+// candidate keeps the quality close to that of `Random`. The domain is fixed when the handle is created, so handles
+// must be created by the thread using them, after the thread is pinned to its cpu.
+template <int cache_level = 3>
+class Hierarchical {
+   public:
+    struct Config {
+        int seed{1};
+        std::size_t push_chunk_size{16};
+        // Consecutive cpus sharing a cache domain. If 0, the domains are read from sysfs.
+        int cores_per_domain{0};
+    };
+
+    struct SharedData {
+        std::atomic_int id_count{0};
+        topology::CacheDomains domains{cache_level};
+
+        explicit SharedData(std::size_t /*num_pqs*/) {
+        }
+    };
+
+   private:
+    pcg32 rng_{};
+    int domain_{};
+    int num_domains_{1};
+
+    // The number of queues is passed in so that all candidates of an operation are drawn from the same, possibly stale,
+    // value while the queues are resized concurrently
+    std::size_t global_pq(std::size_t num_pqs) noexcept {
+        return rng_() & (num_pqs - 1);
+    }
+
+    // Samples a queue of the group of this handle among the first `num_pqs` queues, or any queue if the group has
+    // fewer than `min_size` queues
+    std::size_t local_pq(std::size_t num_pqs, std::size_t min_size) noexcept {
+        auto const d = static_cast<std::size_t>(domain_);
+        auto const n = static_cast<std::size_t>(num_domains_);
+        auto const first = d * num_pqs / n;
+        auto const last = (d + 1) * num_pqs / n;
+        if (last - first < min_size) {
+            return global_pq(num_pqs);
+        }
+        return first + static_cast<std::size_t>((std::uint64_t{rng_()} * (last - first)) >> 32);
+    }
+
+    // Locks the better of a local and a global candidate. Returns nullptr if the locked queue turns out to be empty.
+    template <typename Context, typename Stats>
+    typename Context::guard_type* lock_best_pq(Context& ctx, Stats& stats) {
+        while (true) {
+            auto const num_pqs = ctx.num_pqs();
+            auto best_pq = local_pq(num_pqs, 1);
+            auto other_pq = global_pq(num_pqs);
+            // With fewer than two queues, e.g. after shrinking, the candidates cannot be distinct
+            while (other_pq == best_pq && num_pqs > 1) {
+                other_pq = global_pq(num_pqs);
+            }
+            auto best_key = ctx.pq_guards()[best_pq].top_key();
+            auto other_key = ctx.pq_guards()[other_pq].top_key();
+            if (ctx.compare(best_key, other_key)) {
+                best_pq = other_pq;
+                best_key = other_key;
+            }
+            if (Context::is_sentinel(best_key)) {
+                // Both candidates look empty, so take the next queue marked nonempty instead of giving up
+                best_pq = ctx.nonempty_pqs().find_next(global_pq(num_pqs), num_pqs);
+                if (best_pq == num_pqs) {
+                    stats.empty_pop();
+                    return nullptr;
+                }
+            }
+            auto& guard = ctx.pq_guards()[best_pq];
+            if (!guard.try_lock()) {
+                stats.failed_lock();
+                continue;
+            }
+            if (guard.get_pq().empty()) {
+                guard.unlock();
+                stats.empty_pop();
+                return nullptr;
+            }
+            return &guard;
+        }
+    }
+
+    // Locks a queue of the local group. If the group has a single queue, other queues are tried once it is locked.
+    template <typename Context, typename Stats>
+    typename Context::guard_type& lock_push_pq(Context& ctx, Stats& stats) {
+        std::size_t i = local_pq(ctx.num_pqs(), 1);
+        while (!ctx.pq_guards()[i].try_lock()) {
+            stats.failed_lock();
+            i = local_pq(ctx.num_pqs(), 2);
+        }
+        return ctx.pq_guards()[i];
+    }
+
+   protected:
+    explicit Hierarchical(Config const& config, SharedData& shared_data) noexcept {
+        auto const cpu = topology::current_cpu();
+        if (config.cores_per_domain > 0) {
+            auto const num_cpus = std::max(static_cast<int>(std::thread::hardware_concurrency()), cpu + 1);
+            domain_ = cpu / config.cores_per_domain;
+            num_domains_ = (num_cpus + config.cores_per_domain - 1) / config.cores_per_domain;
+        } else {
+            domain_ = shared_data.domains.domain_of(cpu);
+            num_domains_ = shared_data.domains.num_domains();
+        }
+        assert(domain_ >= 0 && domain_ < num_domains_);
+        auto id = shared_data.id_count.fetch_add(1, std::memory_order_relaxed);
+        auto seq = std::seed_seq{config.seed, id};
+        rng_.seed(seq);
+    }
+
+    template <typename Context, typename Stats>
+    std::optional<typename Context::value_type> try_pop(Context& ctx, Stats& stats) {
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return std::nullopt;
+        }
+        auto v = guard->get_pq().extract_top();
+        guard->popped();
+        guard->unlock();
+        return v;
+    }
+
+    // Pops up to `k` elements from the best candidate queue and returns the number of elements written to `out`
+    template <typename Context, typename Stats, typename OutputIt>
+    std::size_t try_pop_n(Context& ctx, Stats& stats, OutputIt out, std::size_t k) {
+        assert(k > 0);
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return 0;
+        }
+        std::size_t n = 0;
+        do {
+            *out++ = guard->get_pq().extract_top();
+            ++n;
+        } while (n != k && !guard->get_pq().empty());
+        guard->popped();
+        guard->unlock();
+        return n;
+    }
+
+    template <typename Context, typename Stats, typename Value>
+    void push(Context& ctx, Stats& stats, Value&& v) {
+        auto& guard = lock_push_pq(ctx, stats);
+        guard.get_pq().push(std::forward<Value>(v));
+        guard.pushed();
+        guard.unlock();
+    }
+
+    // Pushes the range in chunks of at most `push_chunk_size` elements, each chunk into a queue of the local group
+    // under a single lock acquisition. Returns the number of pushed elements.
+    template <typename Context, typename Stats, typename InputIt>
+    std::size_t push(Context& ctx, Stats& stats, InputIt first, InputIt last) {
+        assert(ctx.config().push_chunk_size > 0);
+        std::size_t num_pushed = 0;
+        while (first != last) {
+            auto& guard = lock_push_pq(ctx, stats);
+            std::size_t n = 0;
+            for (; n != ctx.config().push_chunk_size && first != last; ++n, ++first) {
+                guard.get_pq().push(*first);
+            }
+            num_pushed += n;
+            guard.pushed();
+            guard.unlock();
+        }
+        return num_pushed;
+    }
+};
+
+}  // namespace multiqueue::mode
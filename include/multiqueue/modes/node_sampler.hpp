@@ -0,0 +1,42 @@
+#pragma once
+
+#include "multiqueue/numa.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace multiqueue::mode::detail {
+
+// Samples random queues, preferring the queues of the NUMA node of the thread that created the sampler. Handles must
+// therefore be created by the thread using them.
+class NodeSampler {
+    int node_;
+    std::uint32_t remote_threshold_;
+
+   public:
+    // `remote_chance` is the chance to sample a queue from any node instead of the local node
+    explicit NodeSampler(double remote_chance) noexcept
+        : node_{numa::current_node()},
+          remote_threshold_{static_cast<std::uint32_t>(std::clamp(remote_chance, 0.0, 1.0) *
+                                                       std::numeric_limits<std::uint32_t>::max())} {
+    }
+
+    // Samples a random queue among the first `num_pqs` queues. The local node is only preferred if it has at least
+    // `min_local_pqs` queues, e.g. to choose distinct candidates from. The number of queues is passed in so that all
+    // candidates are drawn from the same, possibly stale, value while the queues are resized concurrently.
+    template <typename Context, typename RNG>
+    std::size_t operator()(Context const& ctx, std::size_t num_pqs, std::size_t min_local_pqs,
+                           RNG& rng) const noexcept {
+        if (ctx.num_nodes() > 1 && rng() >= remote_threshold_) {
+            auto [first, last] = ctx.node_pqs(node_ % ctx.num_nodes(), num_pqs);
+            if (last - first >= min_local_pqs) {
+                return first + static_cast<std::size_t>((std::uint64_t{rng()} * (last - first)) >> 32);
+            }
+        }
+        return rng() & (num_pqs - 1);
+    }
+};
+
+}  // namespace multiqueue::mode::detail
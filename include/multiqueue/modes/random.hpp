@@ -1,5 +1,7 @@
 #pragma once
 
+#include "multiqueue/modes/node_sampler.hpp"
+
 #include "pcg_random.hpp"
 
 #include <algorithm>
@@ -9,6 +11,7 @@
 #include <cstddef>
 #include <optional>
 #include <random>
+#include <utility>
 
 namespace multiqueue::mode {
 
@@ -19,6 +22,9 @@ class Random {
    public:
     struct Config {
         int seed{1};
+        std::size_t push_chunk_size{16};
+        // Chance to sample a queue from any node instead of the local node
+        double numa_remote_chance{0.1};
     };
 
     struct SharedData {
@@ -30,30 +36,34 @@ class Random {
 
    private:
     pcg32 rng_{};
+    detail::NodeSampler sampler_;
 
+    template <typename Context>
+    std::size_t random_pq(Context const& ctx, std::size_t num_pqs) noexcept {
+        return sampler_(ctx, num_pqs, static_cast<std::size_t>(num_pop_candidates), rng_);
+    }
+
+    template <typename Context>
     std::array<std::size_t, static_cast<std::size_t>(num_pop_candidates)> generate_indices(
-        std::size_t num_pqs) noexcept {
+        Context const& ctx) noexcept {
         std::array<std::size_t, static_cast<std::size_t>(num_pop_candidates)> indices{};
-        indices[0] = rng_() & (num_pqs - 1);
+        auto const num_pqs = ctx.num_pqs();
+        indices[0] = random_pq(ctx, num_pqs);
+        // With fewer queues than candidates, e.g. after shrinking, the candidates cannot be distinct
+        bool const distinct = num_pqs >= static_cast<std::size_t>(num_pop_candidates);
         for (auto it = std::next(indices.begin()); it != indices.end(); ++it) {
             do {
-                *it = rng_() & (num_pqs - 1);
-            } while (std::find(indices.begin(), it, *it) != it);
+                *it = random_pq(ctx, num_pqs);
+            } while (distinct && std::find(indices.begin(), it, *it) != it);
         }
         return indices;
     }
 
-   protected:
-    explicit Random(Config const& config, SharedData& shared_data) noexcept {
-        auto id = shared_data.id_count.fetch_add(1, std::memory_order_relaxed);
-        auto seq = std::seed_seq{config.seed, id};
-        rng_.seed(seq);
-    }
-
-    template <typename Context>
-    std::optional<typename Context::value_type> try_pop(Context& ctx) {
+    // Locks the best of the candidate queues. Returns nullptr if the locked queue turns out to be empty.
+    template <typename Context, typename Stats>
+    typename Context::guard_type* lock_best_pq(Context& ctx, Stats& stats) {
         while (true) {
-            auto indices = generate_indices(ctx.num_pqs());
+            auto indices = generate_indices(ctx);
             auto best_pq = indices[0];
             auto best_key = ctx.pq_guards()[best_pq].top_key();
             for (std::size_t i = 1; i < static_cast<std::size_t>(num_pop_candidates); ++i) {
@@ -63,36 +73,108 @@ class Random {
                     best_key = key;
                 }
             }
+            if (Context::is_sentinel(best_key)) {
+                // All candidates look empty, so take the next queue marked nonempty instead of giving up
+                auto const num_pqs = ctx.num_pqs();
+                best_pq = ctx.nonempty_pqs().find_next(rng_() & (num_pqs - 1), num_pqs);
+                if (best_pq == num_pqs) {
+                    stats.empty_pop();
+                    return nullptr;
+                }
+                best_key = ctx.pq_guards()[best_pq].top_key();
+            }
             auto& guard = ctx.pq_guards()[best_pq];
             if (!guard.try_lock()) {
+                stats.failed_lock();
                 continue;
             }
             if (guard.get_pq().empty()) {
                 guard.unlock();
-                return std::nullopt;
+                stats.empty_pop();
+                return nullptr;
             }
             if (!pop_stale && Context::get_key(guard.get_pq().top()) != best_key) {
                 guard.unlock();
+                stats.stale_pop();
                 continue;
             }
-            auto v = guard.get_pq().top();
-            guard.get_pq().pop();
-            guard.popped();
-            guard.unlock();
-            return v;
+            return &guard;
         }
     }
 
-    template <typename Context>
-    void push(Context& ctx, typename Context::value_type const& v) {
-        std::size_t i{};
+   protected:
+    explicit Random(Config const& config, SharedData& shared_data) noexcept
+        : sampler_{config.numa_remote_chance} {
+        auto id = shared_data.id_count.fetch_add(1, std::memory_order_relaxed);
+        auto seq = std::seed_seq{config.seed, id};
+        rng_.seed(seq);
+    }
+
+    template <typename Context, typename Stats>
+    std::optional<typename Context::value_type> try_pop(Context& ctx, Stats& stats) {
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return std::nullopt;
+        }
+        auto v = guard->get_pq().extract_top();
+        guard->popped();
+        guard->unlock();
+        return v;
+    }
+
+    // Pops up to `k` elements from the best candidate queue and returns the number of elements written to `out`
+    template <typename Context, typename Stats, typename OutputIt>
+    std::size_t try_pop_n(Context& ctx, Stats& stats, OutputIt out, std::size_t k) {
+        assert(k > 0);
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return 0;
+        }
+        std::size_t n = 0;
         do {
-            i = rng_() & (ctx.num_pqs() - 1);
-        } while (!ctx.pq_guards()[i].try_lock());
-        ctx.pq_guards()[i].get_pq().push(v);
+            *out++ = guard->get_pq().extract_top();
+            ++n;
+        } while (n != k && !guard->get_pq().empty());
+        guard->popped();
+        guard->unlock();
+        return n;
+    }
+
+    template <typename Context, typename Stats, typename Value>
+    void push(Context& ctx, Stats& stats, Value&& v) {
+        std::size_t i = random_pq(ctx, ctx.num_pqs());
+        while (!ctx.pq_guards()[i].try_lock()) {
+            stats.failed_lock();
+            i = random_pq(ctx, ctx.num_pqs());
+        }
+        ctx.pq_guards()[i].get_pq().push(std::forward<Value>(v));
         ctx.pq_guards()[i].pushed();
         ctx.pq_guards()[i].unlock();
     }
+
+    // Pushes the range in chunks of at most `push_chunk_size` elements, each chunk into a random queue under a single
+    // lock acquisition. Returns the number of pushed elements.
+    template <typename Context, typename Stats, typename InputIt>
+    std::size_t push(Context& ctx, Stats& stats, InputIt first, InputIt last) {
+        assert(ctx.config().push_chunk_size > 0);
+        std::size_t num_pushed = 0;
+        while (first != last) {
+            std::size_t i = random_pq(ctx, ctx.num_pqs());
+            while (!ctx.pq_guards()[i].try_lock()) {
+                stats.failed_lock();
+                i = random_pq(ctx, ctx.num_pqs());
+            }
+            auto& guard = ctx.pq_guards()[i];
+            std::size_t n = 0;
+            for (; n != ctx.config().push_chunk_size && first != last; ++n, ++first) {
+                guard.get_pq().push(*first);
+            }
+            num_pushed += n;
+            guard.pushed();
+            guard.unlock();
+        }
+        return num_pushed;
+    }
 };
 
 }  // namespace multiqueue::mode
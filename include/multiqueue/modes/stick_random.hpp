@@ -1,5 +1,7 @@
 #pragma once
 
+#include "multiqueue/modes/node_sampler.hpp"
+
 #include "pcg_random.hpp"
 
 #include <algorithm>
@@ -9,6 +11,7 @@
 #include <cstddef>
 #include <optional>
 #include <random>
+#include <utility>
 
 namespace multiqueue::mode {
 
@@ -20,6 +23,9 @@ class StickRandom {
     struct Config {
         int seed{1};
         int stickiness{16};
+        std::size_t push_chunk_size{16};
+        // Chance to sample a queue from any node instead of the local node
+        double numa_remote_chance{0.1};
     };
 
     struct SharedData {
@@ -33,28 +39,38 @@ class StickRandom {
     pcg32 rng{};
     std::array<std::size_t, static_cast<std::size_t>(num_pop_candidates)> pop_index{};
     int count{};
+    detail::NodeSampler sampler_;
+
+    template <typename Context>
+    std::size_t random_pq(Context const& ctx, std::size_t num_pqs) noexcept {
+        return sampler_(ctx, num_pqs, static_cast<std::size_t>(num_pop_candidates), rng);
+    }
 
-    void refresh_pop_index(std::size_t num_pqs) noexcept {
-        pop_index[0] = rng() & (num_pqs - 1);
+    template <typename Context>
+    void refresh_pop_index(Context const& ctx) noexcept {
+        auto const num_pqs = ctx.num_pqs();
+        pop_index[0] = random_pq(ctx, num_pqs);
+        // With fewer queues than candidates, e.g. after shrinking, the candidates cannot be distinct
+        bool const distinct = num_pqs >= static_cast<std::size_t>(num_pop_candidates);
         for (auto it = std::next(pop_index.begin()); it != pop_index.end(); ++it) {
             do {
-                *it = rng() & (num_pqs - 1);
-            } while (std::find(pop_index.begin(), it, *it) != it);
+                *it = random_pq(ctx, num_pqs);
+            } while (distinct && std::find(pop_index.begin(), it, *it) != it);
         }
     }
 
-   protected:
-    explicit StickRandom(Config const& config, SharedData& shared_data) noexcept {
-        auto id = shared_data.id_count.fetch_add(1, std::memory_order_relaxed);
-        auto seq = std::seed_seq{config.seed, id};
-        rng.seed(seq);
+    template <typename Context, typename Stats>
+    void reset_stickiness(Context const& ctx, Stats& stats) noexcept {
+        refresh_pop_index(ctx);
+        count = ctx.config().stickiness;
+        stats.stick_reset();
     }
 
-    template <typename Context>
-    std::optional<typename Context::value_type> try_pop(Context& ctx) {
+    // Locks the best of the sticky candidate queues. Returns nullptr if the locked queue turns out to be empty.
+    template <typename Context, typename Stats>
+    typename Context::guard_type* lock_best_pq(Context& ctx, Stats& stats) {
         if (count == 0) {
-            refresh_pop_index(ctx.num_pqs());
-            count = ctx.config().stickiness;
+            reset_stickiness(ctx, stats);
         }
         while (true) {
             std::size_t best = pop_index[0];
@@ -71,39 +87,105 @@ class StickRandom {
                 if (guard.get_pq().empty()) {
                     guard.unlock();
                     count = 0;
-                    return std::nullopt;
+                    stats.empty_pop();
+                    return nullptr;
                 }
-                auto v = guard.get_pq().top();
-                guard.get_pq().pop();
-                guard.popped();
-                guard.unlock();
-                --count;
-                return v;
+                return &guard;
             }
-            refresh_pop_index(ctx.num_pqs());
-            count = ctx.config().stickiness;
+            stats.failed_lock();
+            reset_stickiness(ctx, stats);
         }
     }
 
-    template <typename Context>
-    void push(Context& ctx, typename Context::value_type const& v) {
+   protected:
+    explicit StickRandom(Config const& config, SharedData& shared_data) noexcept
+        : sampler_{config.numa_remote_chance} {
+        auto id = shared_data.id_count.fetch_add(1, std::memory_order_relaxed);
+        auto seq = std::seed_seq{config.seed, id};
+        rng.seed(seq);
+    }
+
+    template <typename Context, typename Stats>
+    std::optional<typename Context::value_type> try_pop(Context& ctx, Stats& stats) {
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return std::nullopt;
+        }
+        auto v = guard->get_pq().extract_top();
+        guard->popped();
+        guard->unlock();
+        --count;
+        return v;
+    }
+
+    // Pops up to `k` elements from the best candidate queue and returns the number of elements written to `out`
+    template <typename Context, typename Stats, typename OutputIt>
+    std::size_t try_pop_n(Context& ctx, Stats& stats, OutputIt out, std::size_t k) {
+        assert(k > 0);
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return 0;
+        }
+        std::size_t n = 0;
+        do {
+            *out++ = guard->get_pq().extract_top();
+            ++n;
+        } while (n != k && !guard->get_pq().empty());
+        guard->popped();
+        guard->unlock();
+        --count;
+        return n;
+    }
+
+    template <typename Context, typename Stats, typename Value>
+    void push(Context& ctx, Stats& stats, Value&& v) {
         if (count == 0) {
-            refresh_pop_index(ctx.num_pqs());
-            count = ctx.config().stickiness;
+            reset_stickiness(ctx, stats);
         }
         std::size_t push_index = rng() % num_pop_candidates;
         while (true) {
             auto& guard = ctx.pq_guards()[pop_index[push_index]];
             if (guard.try_lock()) {
-                guard.get_pq().push(v);
+                guard.get_pq().push(std::forward<Value>(v));
                 guard.pushed();
                 guard.unlock();
                 --count;
                 return;
             }
-            refresh_pop_index(ctx.num_pqs());
-            count = ctx.config().stickiness;
+            stats.failed_lock();
+            reset_stickiness(ctx, stats);
+        }
+    }
+
+    // Pushes the range in chunks of at most `push_chunk_size` elements, each chunk into a sticky queue under a single
+    // lock acquisition. A chunk counts as one use of the sticky queues. Returns the number of pushed elements.
+    template <typename Context, typename Stats, typename InputIt>
+    std::size_t push(Context& ctx, Stats& stats, InputIt first, InputIt last) {
+        assert(ctx.config().push_chunk_size > 0);
+        std::size_t num_pushed = 0;
+        while (first != last) {
+            if (count == 0) {
+                reset_stickiness(ctx, stats);
+            }
+            std::size_t push_index = rng() % num_pop_candidates;
+            while (true) {
+                auto& guard = ctx.pq_guards()[pop_index[push_index]];
+                if (guard.try_lock()) {
+                    std::size_t n = 0;
+                    for (; n != ctx.config().push_chunk_size && first != last; ++n, ++first) {
+                        guard.get_pq().push(*first);
+                    }
+                    num_pushed += n;
+                    guard.pushed();
+                    guard.unlock();
+                    --count;
+                    break;
+                }
+                stats.failed_lock();
+                reset_stickiness(ctx, stats);
+            }
         }
+        return num_pushed;
     }
 };
 
@@ -11,6 +11,7 @@
 #include <cstddef>
 #include <optional>
 #include <random>
+#include <utility>
 
 namespace multiqueue::mode {
 
@@ -23,11 +24,14 @@ class StickSwap {
         std::atomic<std::size_t> value;
     };
 
+    // The permutation covers the maximum number of queues. Its entries are mapped to the active queues, so that it
+    // does not need to change when the multiqueue is resized.
     using permutation_type = std::vector<AlignedIndex>;
 
     struct Config {
         int seed{1};
         int stickiness{16};
+        std::size_t push_chunk_size{16};
     };
 
     struct SharedData {
@@ -60,12 +64,19 @@ class StickSwap {
         perm[offset_ + index].value.store(new_target, std::memory_order_relaxed);
     }
 
+    // Returns the queue the `index`-th sticky permutation entry of this handle maps to
+    template <typename Context>
+    std::size_t target_pq(Context const& ctx, std::size_t index) noexcept {
+        return ctx.shared_data().permutation[offset_ + index].value.load(std::memory_order_relaxed) &
+               (ctx.num_pqs() - 1);
+    }
+
     template <typename Context>
     std::size_t best_pop_index(Context const& ctx) noexcept {
-        std::size_t best = ctx.shared_data().permutation[offset_].value.load(std::memory_order_relaxed);
+        std::size_t best = target_pq(ctx, 0);
         auto best_key = ctx.pq_guards()[best].top_key();
         for (std::size_t i = 1; i < static_cast<std::size_t>(num_pop_candidates); ++i) {
-            std::size_t target = ctx.shared_data().permutation[offset_ + i].value.load(std::memory_order_relaxed);
+            std::size_t target = target_pq(ctx, i);
             auto key = ctx.pq_guards()[target].top_key();
             if (ctx.compare(best_key, key)) {
                 best = target;
@@ -75,21 +86,20 @@ class StickSwap {
         return best;
     }
 
-   protected:
-    explicit StickSwap(Config const& config, SharedData& shared_data) noexcept {
-        auto id = shared_data.id_count.fetch_add(1, std::memory_order_relaxed);
-        auto seq = std::seed_seq{config.seed, id};
-        rng_.seed(seq);
-        offset_ = static_cast<std::size_t>(id * num_pop_candidates);
+    template <typename Context, typename Stats>
+    void reset_stickiness(Context& ctx, Stats& stats) noexcept {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(num_pop_candidates); ++i) {
+            swap_assignment(ctx.shared_data().permutation, i);
+        }
+        stick_count_ = ctx.config().stickiness;
+        stats.stick_reset();
     }
 
-    template <typename Context>
-    std::optional<typename Context::value_type> try_pop(Context& ctx) {
+    // Locks the best of the sticky candidate queues. Returns nullptr if the locked queue turns out to be empty.
+    template <typename Context, typename Stats>
+    typename Context::guard_type* lock_best_pq(Context& ctx, Stats& stats) {
         if (stick_count_ == 0) {
-            for (std::size_t i = 0; i < static_cast<std::size_t>(num_pop_candidates); ++i) {
-                swap_assignment(ctx.shared_data().permutation, i);
-            }
-            stick_count_ = ctx.config().stickiness;
+            reset_stickiness(ctx, stats);
         }
         while (true) {
             auto& guard = ctx.pq_guards()[best_pop_index(ctx)];
@@ -97,46 +107,105 @@ class StickSwap {
                 if (guard.get_pq().empty()) {
                     guard.unlock();
                     stick_count_ = 0;
-                    return std::nullopt;
+                    stats.empty_pop();
+                    return nullptr;
                 }
-                auto v = guard.get_pq().top();
-                guard.get_pq().pop();
-                guard.popped();
-                guard.unlock();
-                --stick_count_;
-                return v;
-            }
-            for (std::size_t i = 0; i < static_cast<std::size_t>(num_pop_candidates); ++i) {
-                swap_assignment(ctx.shared_data().permutation, i);
+                return &guard;
             }
-            stick_count_ = ctx.config().stickiness;
+            stats.failed_lock();
+            reset_stickiness(ctx, stats);
         }
     }
 
-    template <typename Context>
-    void push(Context& ctx, typename Context::value_type const& v) {
+   protected:
+    explicit StickSwap(Config const& config, SharedData& shared_data) noexcept {
+        auto id = shared_data.id_count.fetch_add(1, std::memory_order_relaxed);
+        auto seq = std::seed_seq{config.seed, id};
+        rng_.seed(seq);
+        offset_ = static_cast<std::size_t>(id * num_pop_candidates);
+    }
+
+    template <typename Context, typename Stats>
+    std::optional<typename Context::value_type> try_pop(Context& ctx, Stats& stats) {
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return std::nullopt;
+        }
+        auto v = guard->get_pq().extract_top();
+        guard->popped();
+        guard->unlock();
+        --stick_count_;
+        return v;
+    }
+
+    // Pops up to `k` elements from the best candidate queue and returns the number of elements written to `out`
+    template <typename Context, typename Stats, typename OutputIt>
+    std::size_t try_pop_n(Context& ctx, Stats& stats, OutputIt out, std::size_t k) {
+        assert(k > 0);
+        auto* guard = lock_best_pq(ctx, stats);
+        if (guard == nullptr) {
+            return 0;
+        }
+        std::size_t n = 0;
+        do {
+            *out++ = guard->get_pq().extract_top();
+            ++n;
+        } while (n != k && !guard->get_pq().empty());
+        guard->popped();
+        guard->unlock();
+        --stick_count_;
+        return n;
+    }
+
+    template <typename Context, typename Stats, typename Value>
+    void push(Context& ctx, Stats& stats, Value&& v) {
         if (stick_count_ == 0) {
-            for (std::size_t i = 0; i < static_cast<std::size_t>(num_pop_candidates); ++i) {
-                swap_assignment(ctx.shared_data().permutation, i);
-            }
-            stick_count_ = ctx.config().stickiness;
+            reset_stickiness(ctx, stats);
         }
         std::size_t push_index = rng_() % num_pop_candidates;
         while (true) {
-            auto target = ctx.shared_data().permutation[offset_ + push_index].value.load(std::memory_order_relaxed);
-            auto& guard = ctx.pq_guards()[target];
+            auto& guard = ctx.pq_guards()[target_pq(ctx, push_index)];
             if (guard.try_lock()) {
-                guard.get_pq().push(v);
+                guard.get_pq().push(std::forward<Value>(v));
                 guard.pushed();
                 guard.unlock();
                 --stick_count_;
                 return;
             }
-            for (std::size_t i = 0; i < static_cast<std::size_t>(num_pop_candidates); ++i) {
-                swap_assignment(ctx.shared_data().permutation, i);
+            stats.failed_lock();
+            reset_stickiness(ctx, stats);
+        }
+    }
+
+    // Pushes the range in chunks of at most `push_chunk_size` elements, each chunk into a sticky queue under a single
+    // lock acquisition. A chunk counts as one use of the sticky queues. Returns the number of pushed elements.
+    template <typename Context, typename Stats, typename InputIt>
+    std::size_t push(Context& ctx, Stats& stats, InputIt first, InputIt last) {
+        assert(ctx.config().push_chunk_size > 0);
+        std::size_t num_pushed = 0;
+        while (first != last) {
+            if (stick_count_ == 0) {
+                reset_stickiness(ctx, stats);
+            }
+            std::size_t push_index = rng_() % num_pop_candidates;
+            while (true) {
+                auto& guard = ctx.pq_guards()[target_pq(ctx, push_index)];
+                if (guard.try_lock()) {
+                    std::size_t n = 0;
+                    for (; n != ctx.config().push_chunk_size && first != last; ++n, ++first) {
+                        guard.get_pq().push(*first);
+                    }
+                    num_pushed += n;
+                    guard.pushed();
+                    guard.unlock();
+                    --stick_count_;
+                    break;
+                }
+                stats.failed_lock();
+                reset_stickiness(ctx, stats);
             }
-            stick_count_ = ctx.config().stickiness;
         }
+        return num_pushed;
     }
 };
 
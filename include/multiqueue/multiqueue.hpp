@@ -9,32 +9,70 @@
 **/
 #pragma once
 
+#include "multiqueue/bucket_queue.hpp"
 #include "multiqueue/buffered_pq.hpp"
 #include "multiqueue/handle.hpp"
 #include "multiqueue/heap.hpp"
+#include "multiqueue/key_value_heap.hpp"
 #include "multiqueue/modes/random.hpp"
+#include "multiqueue/nonempty_bitmap.hpp"
+#include "multiqueue/numa.hpp"
+#include "multiqueue/parking.hpp"
 #include "multiqueue/pq_guard.hpp"
+#include "multiqueue/radix_heap.hpp"
+#include "multiqueue/sequence_heap.hpp"
 #include "multiqueue/sentinel.hpp"
+#include "multiqueue/size_counter.hpp"
+#include "multiqueue/stats.hpp"
 #include "multiqueue/utils.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace multiqueue {
 
 template <typename Value, typename KeyOfValue, typename Compare>
 using DefaultPriorityQueue = BufferedPQ<Heap<Value, utils::ValueCompare<Value, KeyOfValue, Compare>>>;
 
+// Stores the keys and the mapped values of a `KeyValueMultiQueue` in separate arrays, see `KeyValueHeap`
+template <typename Key, typename T, typename Compare>
+using KeyValuePriorityQueue = BufferedPQ<KeyValueHeap<Key, T, Compare>>;
+
+// For integer keys that are popped in almost monotone order, e.g. by label-setting algorithms, see `RadixHeap`
+template <typename Value, typename KeyOfValue, typename Compare>
+using RadixPriorityQueue = BufferedPQ<RadixHeap<Value, KeyOfValue, Compare>>;
+
+// For queues much larger than the cache, see `SequenceHeap`
+template <typename Value, typename KeyOfValue, typename Compare>
+using SequencePriorityQueue = BufferedPQ<SequenceHeap<Value, utils::ValueCompare<Value, KeyOfValue, Compare>>>;
+
+// For integer keys in [0, num_buckets), see `BucketQueue`
+template <typename Value, typename KeyOfValue, typename Compare, std::size_t num_buckets = 4096>
+using BucketPriorityQueue = BufferedPQ<BucketQueue<Value, KeyOfValue, Compare, num_buckets>>;
+
+// Tag for the maximum number of queues a multiqueue can be resized to, see `MultiQueue::resize`
+struct MaxPQs {
+    std::size_t value;
+};
+
 struct DefaultPolicy {
     using mode_type = mode::Random<>;
     static constexpr int pop_tries = 1;
     static constexpr bool scan = true;
+    static constexpr bool collect_stats = false;
 };
 
 template <typename Key, typename Value, typename KeyOfValue, typename Compare = std::less<>,
@@ -69,59 +107,166 @@ class MultiQueue {
         using policy_type = MultiQueue::policy_type;
         using guard_type = MultiQueue::guard_type;
         using shared_data_type = typename policy_type::mode_type::SharedData;
+        using stats_registry_type = stats::Registry<stats::is_enabled<policy_type>::value>;
 
        private:
-        size_type num_pqs_{};
+        std::atomic<size_type> num_pqs_{};
+        size_type max_num_pqs_{};
+        numa::Placement placement_;
         guard_type *pq_guards_{nullptr};
+        NonEmptyBitmap nonempty_pqs_;
+        std::atomic<std::size_t> handle_count_{0};
         [[no_unique_address]] config_type config_;
         [[no_unique_address]] shared_data_type data_;
         [[no_unique_address]] key_compare comp_;
         [[no_unique_address]] internal_allocator_type alloc_;
+        Parking parking_;
+        SizeCounter size_counter_;
+        [[no_unique_address]] stats_registry_type stats_registry_;
+        std::mutex resize_mutex_;
 
-        explicit Context(size_type num_pqs, config_type const &config, priority_queue_type const &pq,
-                         key_compare const &comp, allocator_type const &alloc)
+        explicit Context(size_type num_pqs, MaxPQs max_num_pqs, config_type const &config,
+                         priority_queue_type const &pq, key_compare const &comp, allocator_type const &alloc)
             : num_pqs_{num_pqs},
-              pq_guards_{std::allocator_traits<internal_allocator_type>::allocate(alloc_, num_pqs_)},
+              max_num_pqs_{max_num_pqs.value},
+              placement_{max_num_pqs_},
+              pq_guards_{std::allocator_traits<internal_allocator_type>::allocate(alloc_, max_num_pqs_)},
+              nonempty_pqs_{max_num_pqs_},
               config_{config},
-              data_{num_pqs_},
+              data_{max_num_pqs_},
               comp_{comp},
               alloc_{alloc} {
-            assert(num_pqs_ > 0);
+            assert(num_pqs > 0 && num_pqs <= max_num_pqs_);
 
-            for (auto *it = pq_guards_; it != pq_guards_ + num_pqs_; ++it) {
+            bind_guards();
+            for (auto *it = pq_guards_; it != pq_guards_ + max_num_pqs_; ++it) {
                 std::allocator_traits<internal_allocator_type>::construct(alloc_, it, pq);
             }
+            // Inactive queues are empty and stay locked, so that no handle can use them
+            for (auto *it = pq_guards_ + num_pqs; it != pq_guards_ + max_num_pqs_; ++it) {
+                it->get_pq().clear();
+                it->try_lock();
+            }
+            attach_guards();
+        }
+
+        explicit Context(size_type num_pqs, config_type const &config, priority_queue_type const &pq,
+                         key_compare const &comp, allocator_type const &alloc)
+            : Context(num_pqs, MaxPQs{num_pqs}, config, pq, comp, alloc) {
         }
 
         explicit Context(size_type num_pqs, typename priority_queue_type::size_type initial_capacity,
                          config_type const &config, priority_queue_type const &pq, key_compare const &comp,
                          allocator_type const &alloc)
-            : Context(num_pqs, config, pq, comp, alloc) {
-            auto cap_per_queue = 2 * (initial_capacity + num_pqs - 1) / num_pqs;
-            for (auto *it = pq_guards_; it != pq_guards_ + num_pqs_; ++it) {
-                it->get_pq().reserve(cap_per_queue);
-            }
+            : Context(num_pqs, MaxPQs{num_pqs}, config, pq, comp, alloc) {
+            reserve_on_nodes(2 * (initial_capacity + num_pqs - 1) / num_pqs);
         }
 
         template <typename ForwardIt>
         explicit Context(ForwardIt first, ForwardIt last, config_type const &config, key_compare const &comp,
                          allocator_type const &alloc)
-            : num_pqs_{std::distance(first, last)},
-              pq_guards_{std::allocator_traits<internal_allocator_type>::allocate(alloc_, num_pqs_)},
+            : num_pqs_{static_cast<size_type>(std::distance(first, last))},
+              max_num_pqs_{num_pqs_.load(std::memory_order_relaxed)},
+              placement_{max_num_pqs_},
+              pq_guards_{std::allocator_traits<internal_allocator_type>::allocate(alloc_, max_num_pqs_)},
+              nonempty_pqs_{max_num_pqs_},
               config_{config},
-              data_{num_pqs_},
+              data_{max_num_pqs_},
               comp_{comp},
               alloc_(alloc) {
-            for (auto *it = pq_guards_; it != pq_guards_ + num_pqs_; ++it, ++first) {
+            bind_guards();
+            size_type size = 0;
+            for (auto *it = pq_guards_; it != pq_guards_ + max_num_pqs_; ++it, ++first) {
                 std::allocator_traits<internal_allocator_type>::construct(alloc_, it, *first);
+                size += it->get_pq().size();
             }
+            attach_guards();
+            size_counter_.reset(size);
+        }
+
+        void attach_guards() {
+            for (size_type i = 0; i < max_num_pqs_; ++i) {
+                pq_guards_[i].attach(nonempty_pqs_, i);
+            }
+        }
+
+        // Binds the memory of the guards to the node they belong to, must be called before the guards are constructed
+        void bind_guards() noexcept {
+            placement_.bind(pq_guards_, sizeof(guard_type));
+        }
+
+        // Reserves storage for `cap_per_queue` elements in every queue, allocated on the node the queue belongs to
+        void reserve_on_nodes(size_type cap_per_queue) {
+            for (int node = 0; node < placement_.num_nodes(); ++node) {
+                numa::run_on_node(node, [&] {
+                    auto [first, last] = placement_.node_pqs(node);
+                    for (auto *it = pq_guards_ + first; it != pq_guards_ + last; ++it) {
+                        it->get_pq().reserve(cap_per_queue);
+                    }
+                });
+            }
+        }
+
+        // Locks the guard, waiting for concurrent operations on it to finish
+        static void lock_guard(guard_type &guard) noexcept {
+            while (!guard.try_lock()) {
+                std::this_thread::yield();
+            }
+        }
+
+        void resize(size_type new_num_pqs) {
+            std::lock_guard lock{resize_mutex_};
+            auto const old_num_pqs = num_pqs_.load(std::memory_order_relaxed);
+            if (new_num_pqs > old_num_pqs) {
+                // The inactive queues are empty, so they can be handed out right away
+                for (auto *it = pq_guards_ + old_num_pqs; it != pq_guards_ + new_num_pqs; ++it) {
+                    it->unlock();
+                }
+                num_pqs_.store(new_num_pqs, std::memory_order_release);
+                return;
+            }
+            if (new_num_pqs == old_num_pqs) {
+                return;
+            }
+            // The elements are in flight while they are redistributed. Counting as handle prevents the parking from
+            // detecting termination in the meantime.
+            parking_.register_handle();
+            num_pqs_.store(new_num_pqs, std::memory_order_release);
+            std::vector<value_type> values;
+            for (auto *it = pq_guards_ + new_num_pqs; it != pq_guards_ + old_num_pqs; ++it) {
+                // Handles that sampled the queue before the store to `num_pqs_` may still use it, but once locked
+                // here, it stays locked until the queue is activated again
+                lock_guard(*it);
+                auto &pq = it->get_pq();
+                while (!pq.empty()) {
+                    values.push_back(pq.extract_top());
+                }
+                pq.clear();
+                it->popped();
+            }
+            // Every remaining queue gets every `new_num_pqs`-th value, so that no queue gets only the best values of a
+            // retired queue
+            std::vector<value_type> part;
+            for (size_type i = 0; i < new_num_pqs && i < values.size(); ++i) {
+                part.clear();
+                for (size_type j = i; j < values.size(); j += new_num_pqs) {
+                    part.push_back(std::move(values[j]));
+                }
+                auto &guard = pq_guards_[i];
+                lock_guard(guard);
+                guard.get_pq().push_range(std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+                guard.pushed();
+                guard.unlock();
+            }
+            parking_.notify_all();
+            parking_.deregister_handle();
         }
 
         ~Context() noexcept {
-            for (auto *it = pq_guards_; it != pq_guards_ + num_pqs_; ++it) {
+            for (auto *it = pq_guards_; it != pq_guards_ + max_num_pqs_; ++it) {
                 std::allocator_traits<internal_allocator_type>::destroy(alloc_, it);
             }
-            std::allocator_traits<internal_allocator_type>::deallocate(alloc_, pq_guards_, num_pqs_);
+            std::allocator_traits<internal_allocator_type>::deallocate(alloc_, pq_guards_, max_num_pqs_);
         }
 
        public:
@@ -130,14 +275,44 @@ class MultiQueue {
         Context &operator=(const Context &) = delete;
         Context &operator=(Context &&) = delete;
 
-        [[nodiscard]] constexpr size_type num_pqs() const noexcept {
-            return num_pqs_;
+        // The number of active queues can change concurrently, but indices below `max_num_pqs()` are always valid.
+        // Inactive queues are locked.
+        [[nodiscard]] size_type num_pqs() const noexcept {
+            return num_pqs_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_type max_num_pqs() const noexcept {
+            return max_num_pqs_;
+        }
+
+        [[nodiscard]] int num_nodes() const noexcept {
+            return placement_.num_nodes();
+        }
+
+        // Returns the range of active queue indices [first, last) that belong to `node` if there are `num_pqs` active
+        // queues. The queues stay on their nodes when resizing, so the range is empty if all of them are inactive.
+        [[nodiscard]] std::pair<size_type, size_type> node_pqs(int node, size_type num_pqs) const noexcept {
+            return placement_.node_pqs(node, num_pqs);
+        }
+
+        // Returns the range of active queue indices [first, last) that belong to `node`
+        [[nodiscard]] std::pair<size_type, size_type> node_pqs(int node) const noexcept {
+            return node_pqs(node, num_pqs());
         }
 
         [[nodiscard]] guard_type *pq_guards() const noexcept {
             return pq_guards_;
         }
 
+        [[nodiscard]] NonEmptyBitmap const &nonempty_pqs() const noexcept {
+            return nonempty_pqs_;
+        }
+
+        // Returns a distinct number for every handle
+        [[nodiscard]] std::size_t next_handle_id() noexcept {
+            return handle_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
         [[nodiscard]] config_type const &config() const noexcept {
             return config_;
         }
@@ -154,6 +329,18 @@ class MultiQueue {
             return comp_;
         }
 
+        [[nodiscard]] Parking &parking() noexcept {
+            return parking_;
+        }
+
+        [[nodiscard]] SizeCounter &size_counter() noexcept {
+            return size_counter_;
+        }
+
+        [[nodiscard]] stats_registry_type &stats_registry() noexcept {
+            return stats_registry_;
+        }
+
         [[nodiscard]] bool compare(key_type const &lhs, key_type const &rhs) const noexcept {
             return Sentinel::compare(comp_, lhs, rhs);
         }
@@ -166,7 +353,9 @@ class MultiQueue {
             return Sentinel::is_sentinel(key);
         }
 
-        [[nodiscard]] static constexpr key_type get_key(value_type const &value) noexcept {
+        // Also accepts the pair of references returned by `KeyValueHeap::top`
+        template <typename V>
+        [[nodiscard]] static constexpr key_type get_key(V const &value) noexcept {
             return KeyOfValue::get(value);
         }
     };
@@ -176,6 +365,9 @@ class MultiQueue {
    public:
     using handle_type = Handle<Context>;
 
+    // On NUMA systems, the guards of the queues are placed on the nodes the queues belong to, but the storage of the
+    // queues is allocated by the threads pushing into them. Only the constructors that know the capacity up front, i.e.
+    // the ones taking an initial capacity or the values to construct from, also place the storage on the nodes.
     explicit MultiQueue(size_type num_pqs, config_type const &config = {},
                         priority_queue_type const &pq = priority_queue_type(), key_compare const &comp = {},
                         allocator_type const &alloc = {})
@@ -188,18 +380,97 @@ class MultiQueue {
         : context_{num_pqs, initial_capacity, config, pq, comp, internal_allocator_type(alloc)} {
     }
 
+    // Constructs the multiqueue with `num_pqs` queues which can be resized to up to `max_num_pqs` queues. Storage for
+    // the maximum number of queues is allocated up front.
+    explicit MultiQueue(size_type num_pqs, MaxPQs max_num_pqs, config_type const &config = {},
+                        priority_queue_type const &pq = priority_queue_type(), key_compare const &comp = {},
+                        allocator_type const &alloc = {})
+        : context_{num_pqs, max_num_pqs, config, pq, comp, internal_allocator_type(alloc)} {
+    }
+
+    // Constructs the multiqueue with copies of the queues in [first, last), whose storage is allocated by the calling
+    // thread
     template <typename ForwardIt>
     explicit MultiQueue(ForwardIt first, ForwardIt last, config_type const &config = {}, key_compare const &comp = {},
                         allocator_type const &alloc = {})
         : context_{first, last, config, comp, internal_allocator_type(alloc)} {
     }
 
-    handle_type get_handle() noexcept {
+    // Constructs the multiqueue with the values in [first, last), see `assign`
+    template <typename RandomIt>
+    explicit MultiQueue(size_type num_pqs, RandomIt first, RandomIt last, unsigned int num_threads,
+                        config_type const &config = {}, priority_queue_type const &pq = priority_queue_type(),
+                        key_compare const &comp = {}, allocator_type const &alloc = {})
+        : context_{num_pqs, static_cast<typename priority_queue_type::size_type>(std::distance(first, last)), config,
+                   pq, comp, internal_allocator_type(alloc)} {
+        assign(first, last, num_threads);
+    }
+
+    // Replaces the content of all queues with the values in [first, last), using `num_threads` threads, but at least
+    // one and at most one per queue. Each thread fills a disjoint set of queues without locking and builds each queue
+    // in linear time. The values are distributed in blocks round-robin over the queues, such that every queue gets
+    // values from the whole range. Must not be called concurrently with any handle operation.
+    template <typename RandomIt>
+    void assign(RandomIt first, RandomIt last, unsigned int num_threads = 1) {
+        num_threads = static_cast<unsigned int>(std::clamp<size_type>(num_threads, 1, num_pqs()));
+        auto const n = static_cast<size_type>(std::distance(first, last));
+        // Contiguous blocks are cheaper to read, but every queue should get enough blocks to cover the whole range
+        size_type const block_size = std::clamp(n / (num_pqs() * 64), size_type{1}, size_type{64});
+        size_type const stride = block_size * num_pqs();
+        auto fill = [&](size_type id) {
+            std::vector<value_type> values;
+            values.reserve((n / stride + 1) * block_size);
+            for (size_type i = id; i < num_pqs(); i += num_threads) {
+                values.clear();
+                for (size_type block = i * block_size; block < n; block += stride) {
+                    auto const block_end = std::min(block + block_size, n);
+                    values.insert(values.end(), first + static_cast<std::ptrdiff_t>(block),
+                                  first + static_cast<std::ptrdiff_t>(block_end));
+                }
+                auto &guard = context_.pq_guards_[i];
+                guard.get_pq().clear();
+                guard.get_pq().push_range(std::make_move_iterator(values.begin()),
+                                          std::make_move_iterator(values.end()));
+                // Publishes the new top key
+                guard.popped();
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads - 1);
+        for (size_type id = 1; id < num_threads; ++id) {
+            threads.emplace_back(fill, id);
+        }
+        fill(0);
+        for (auto &t : threads) {
+            t.join();
+        }
+        context_.size_counter_.reset(n);
+        context_.parking_.resume();
+    }
+
+    handle_type get_handle() {
         return handle_type(context_);
     }
 
-    [[nodiscard]] constexpr size_type num_pqs() const noexcept {
-        return context_.num_pqs_;
+    [[nodiscard]] size_type num_pqs() const noexcept {
+        return context_.num_pqs();
+    }
+
+    [[nodiscard]] size_type max_num_pqs() const noexcept {
+        return context_.max_num_pqs_;
+    }
+
+    // Changes the number of queues to `new_num_pqs`, which must be a power of two not larger than `max_num_pqs()`.
+    // Can be called while handles are in use. When shrinking, the elements of the deactivated queues are
+    // redistributed among the remaining queues and are invisible to handles in the meantime. The modes may require
+    // a minimum number of queues, e.g. the number of pop candidates.
+    void resize(size_type new_num_pqs) {
+        assert(new_num_pqs > 0 && (new_num_pqs & (new_num_pqs - 1)) == 0 && new_num_pqs <= max_num_pqs());
+        context_.resize(new_num_pqs);
+    }
+
+    [[nodiscard]] int num_nodes() const noexcept {
+        return context_.num_nodes();
     }
 
     [[nodiscard]] key_compare key_comp() const {
@@ -217,6 +488,29 @@ class MultiQueue {
     [[nodiscard]] static constexpr key_type sentinel() noexcept {
         return Context::sentinel();
     }
+
+    // Returns the number of elements, summed up from the per-handle counters without locking any queue. The result is
+    // exact if no operation is in flight.
+    [[nodiscard]] size_type approx_size() const {
+        return context_.size_counter_.size();
+    }
+
+    // Returns true if the multiqueue might be empty, see `approx_size`
+    [[nodiscard]] bool maybe_empty() const {
+        return approx_size() == 0;
+    }
+
+    // Returns the operation statistics summed up over all handles, including destroyed ones. The counts of handles
+    // in use are read without synchronization. If the policy does not enable statistics, all counts are zero.
+    [[nodiscard]] OperationStats stats() const {
+        return context_.stats_registry_.snapshot();
+    }
+
+    // Returns true if the multiqueue ran empty while all handles were blocked in `pop` or `pop_for` and no elements
+    // were pushed since
+    [[nodiscard]] bool terminated() const noexcept {
+        return context_.parking_.terminated();
+    }
 };
 
 template <typename T, typename Compare = std::less<>, typename Policy = DefaultPolicy,
@@ -226,7 +520,26 @@ using ValueMultiQueue = MultiQueue<T, T, utils::Identity, Compare, Policy, Prior
 
 template <typename Key, typename T, typename Compare = std::less<>, typename Policy = DefaultPolicy,
           typename PriorityQueue = DefaultPriorityQueue<std::pair<Key, T>, utils::PairFirst, Compare>,
-          typename Sentinel = sentinel::Implicit<T, Compare>, typename Allocator = std::allocator<PriorityQueue>>
+          typename Sentinel = sentinel::Implicit<Key, Compare>, typename Allocator = std::allocator<PriorityQueue>>
 using KeyValueMultiQueue =
     MultiQueue<Key, std::pair<Key, T>, utils::PairFirst, Compare, Policy, PriorityQueue, Sentinel, Allocator>;
+
+namespace detail {
+
+// Rejects sentinels that are valid keys of the bucket queue, since a queue with that top key would look empty
+template <typename Sentinel, typename BucketQueue>
+struct BucketSentinel : Sentinel {
+    static_assert(!BucketQueue::is_valid_key(Sentinel::sentinel()), "The sentinel must not be in [0, num_buckets)");
+};
+
+}  // namespace detail
+
+// Multiqueue of integers in [0, num_buckets) with a bucket queue per queue. The default sentinel is the maximum of `T`,
+// since the usual sentinel of a max-queue of unsigned integers is 0, which is a valid key.
+template <typename T, typename Compare = std::less<>, std::size_t num_buckets = 4096, typename Policy = DefaultPolicy,
+          typename Sentinel = sentinel::Explicit<T, Compare, std::numeric_limits<T>::max()>,
+          typename Allocator = std::allocator<BucketPriorityQueue<T, utils::Identity, Compare, num_buckets>>>
+using BucketMultiQueue =
+    MultiQueue<T, T, utils::Identity, Compare, Policy, BucketPriorityQueue<T, utils::Identity, Compare, num_buckets>,
+               detail::BucketSentinel<Sentinel, BucketQueue<T, utils::Identity, Compare, num_buckets>>, Allocator>;
 }  // namespace multiqueue
@@ -0,0 +1,113 @@
+/**
+******************************************************************************
+* @file:   nonempty_bitmap.hpp
+*
+* @brief:  Hierarchical bitmap of the nonempty queues
+*******************************************************************************
+**/
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace multiqueue {
+
+// One bit per queue, set while the queue is nonempty, and one summary bit per word of queue bits, set while the word
+// is nonzero. The bit of a queue is only changed while holding the lock of the queue, on transitions between empty and
+// nonempty. Readers do not lock, so the bitmap is only a hint. A cleared summary bit is rechecked, so the summary can
+// only miss a nonempty word transiently.
+class NonEmptyBitmap {
+    using word_type = std::uint64_t;
+    static constexpr std::size_t bits_per_word = 64;
+
+    std::size_t num_words_;
+    std::unique_ptr<std::atomic<word_type>[]> words_;
+    std::unique_ptr<std::atomic<word_type>[]> summary_;
+
+    static std::size_t count_trailing_zeros(word_type w) noexcept {
+        assert(w != 0);
+        return static_cast<std::size_t>(__builtin_ctzll(w));
+    }
+
+    // Returns the index of the first nonzero word in [first, last) according to the summary, or `last`
+    [[nodiscard]] std::size_t find_word(std::size_t first, std::size_t last) const noexcept {
+        while (first < last) {
+            auto const s = first / bits_per_word;
+            auto const w = summary_[s].load(std::memory_order_relaxed) & (~word_type{0} << (first % bits_per_word));
+            if (w != 0) {
+                auto const index = s * bits_per_word + count_trailing_zeros(w);
+                return index < last ? index : last;
+            }
+            first = (s + 1) * bits_per_word;
+        }
+        return last;
+    }
+
+   public:
+    explicit NonEmptyBitmap(std::size_t size)
+        : num_words_{(size + bits_per_word - 1) / bits_per_word},
+          words_{std::make_unique<std::atomic<word_type>[]>(num_words_)},
+          summary_{std::make_unique<std::atomic<word_type>[]>((num_words_ + bits_per_word - 1) / bits_per_word)} {
+    }
+
+    void set(std::size_t index) noexcept {
+        auto const w = index / bits_per_word;
+        auto const old = words_[w].fetch_or(word_type{1} << (index % bits_per_word));
+        if (old == 0) {
+            summary_[w / bits_per_word].fetch_or(word_type{1} << (w % bits_per_word));
+        }
+    }
+
+    void reset(std::size_t index) noexcept {
+        auto const w = index / bits_per_word;
+        auto const mask = word_type{1} << (index % bits_per_word);
+        if ((words_[w].fetch_and(~mask) & ~mask) == 0) {
+            auto const summary_mask = word_type{1} << (w % bits_per_word);
+            summary_[w / bits_per_word].fetch_and(~summary_mask);
+            // Another queue of this word might have become nonempty before the summary bit was cleared
+            if (words_[w].load() != 0) {
+                summary_[w / bits_per_word].fetch_or(summary_mask);
+            }
+        }
+    }
+
+    [[nodiscard]] bool test(std::size_t index) const noexcept {
+        return (words_[index / bits_per_word].load(std::memory_order_relaxed) >> (index % bits_per_word)) & 1;
+    }
+
+    // Returns the index of the first set bit in [first, last), or `last` if there is none
+    [[nodiscard]] std::size_t find_first(std::size_t first, std::size_t last) const noexcept {
+        while (first < last) {
+            auto const w = first / bits_per_word;
+            auto const word = words_[w].load(std::memory_order_relaxed) & (~word_type{0} << (first % bits_per_word));
+            if (word != 0) {
+                auto const index = w * bits_per_word + count_trailing_zeros(word);
+                return index < last ? index : last;
+            }
+            auto const next_word = find_word(w + 1, (last + bits_per_word - 1) / bits_per_word);
+            first = next_word * bits_per_word;
+        }
+        return last;
+    }
+
+    // Returns the index of the first set bit in [start, size), continuing with [0, start), or `size` if there is none
+    [[nodiscard]] std::size_t find_next(std::size_t start, std::size_t size) const noexcept {
+        assert(start < size);
+        if (auto index = find_first(start, size); index != size) {
+            return index;
+        }
+        auto index = find_first(0, start);
+        return index != start ? index : size;
+    }
+
+    // Returns true if any of the first `size` bits is set
+    [[nodiscard]] bool any(std::size_t size) const noexcept {
+        return find_first(0, size) != size;
+    }
+};
+
+}  // namespace multiqueue
@@ -0,0 +1,145 @@
+/**
+******************************************************************************
+* @file:   numa.hpp
+*
+* @brief:  Thin wrapper around libnuma
+*
+* If the multiqueue is built without libnuma (MULTIQUEUE_HAVE_NUMA is not
+* defined) or libnuma is not available at runtime, the system is treated as a
+* single node.
+*******************************************************************************
+**/
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+#ifdef MULTIQUEUE_HAVE_NUMA
+#include <numa.h>
+#include <sched.h>
+
+#include <cstdint>
+#include <thread>
+
+#include "multiqueue/build_config.hpp"
+#endif
+
+namespace multiqueue::numa {
+
+#ifdef MULTIQUEUE_HAVE_NUMA
+
+inline bool available() noexcept {
+    static bool const is_available = numa_available() >= 0;
+    return is_available;
+}
+
+inline int num_nodes() noexcept {
+    return available() ? numa_max_node() + 1 : 1;
+}
+
+// Returns the node of the cpu the calling thread currently runs on
+inline int current_node() noexcept {
+    if (!available()) {
+        return 0;
+    }
+    int cpu = sched_getcpu();
+    int node = cpu < 0 ? 0 : numa_node_of_cpu(cpu);
+    return node < 0 ? 0 : node;
+}
+
+// Sets the memory policy of the pages fully contained in [ptr, ptr + size) to allocate on `node`. Must be called before
+// the memory is touched.
+inline void bind_memory(void *ptr, std::size_t size, int node) noexcept {
+    if (!available()) {
+        return;
+    }
+    auto const first = (reinterpret_cast<std::uintptr_t>(ptr) + build_config::page_size - 1) &
+                       ~(build_config::page_size - 1);
+    auto const last = (reinterpret_cast<std::uintptr_t>(ptr) + size) & ~(build_config::page_size - 1);
+    if (first < last) {
+        numa_tonode_memory(reinterpret_cast<void *>(first), last - first, node);
+    }
+}
+
+// Calls `f` on a thread running on `node`, so that memory allocated and first touched by `f` is local to `node`
+template <typename F>
+void run_on_node(int node, F &&f) {
+    if (!available() || num_nodes() == 1) {
+        std::forward<F>(f)();
+        return;
+    }
+    std::thread t([node, &f] {
+        numa_run_on_node(node);
+        std::forward<F>(f)();
+    });
+    t.join();
+}
+
+#else
+
+constexpr bool available() noexcept {
+    return false;
+}
+
+constexpr int num_nodes() noexcept {
+    return 1;
+}
+
+constexpr int current_node() noexcept {
+    return 0;
+}
+
+inline void bind_memory(void * /*ptr*/, std::size_t /*size*/, int /*node*/) noexcept {
+}
+
+template <typename F>
+void run_on_node(int /*node*/, F &&f) {
+    std::forward<F>(f)();
+}
+
+#endif
+
+// Splits the queues into one contiguous block per node. The split depends only on the maximum number of queues, so
+// that queues stay on their nodes when the number of active queues changes.
+class Placement {
+    std::size_t max_num_pqs_;
+    int num_nodes_;
+
+   public:
+    explicit Placement(std::size_t max_num_pqs, int num_nodes = numa::num_nodes()) noexcept
+        : max_num_pqs_{max_num_pqs},
+          num_nodes_{static_cast<int>(std::min(static_cast<std::size_t>(num_nodes), max_num_pqs))} {
+    }
+
+    [[nodiscard]] int num_nodes() const noexcept {
+        return num_nodes_;
+    }
+
+    // Returns the range of queue indices [first, last) placed on `node`
+    [[nodiscard]] std::pair<std::size_t, std::size_t> node_pqs(int node) const noexcept {
+        assert(node >= 0 && node < num_nodes_);
+        auto const n = static_cast<std::size_t>(node);
+        auto const num_nodes = static_cast<std::size_t>(num_nodes_);
+        return {n * max_num_pqs_ / num_nodes, (n + 1) * max_num_pqs_ / num_nodes};
+    }
+
+    // Returns the range of queue indices [first, last) placed on `node` that are among the first `num_pqs` queues. The
+    // range is empty if all queues of the node are inactive.
+    [[nodiscard]] std::pair<std::size_t, std::size_t> node_pqs(int node, std::size_t num_pqs) const noexcept {
+        auto const [first, last] = node_pqs(node);
+        return {std::min(first, num_pqs), std::min(last, num_pqs)};
+    }
+
+    // Binds the memory of the objects of size `size` for every queue starting at `ptr` to the nodes of the queues
+    void bind(void *ptr, std::size_t size) const noexcept {
+        for (int node = 0; node < num_nodes_; ++node) {
+            auto const [first, last] = node_pqs(node);
+            bind_memory(static_cast<char *>(ptr) + first * size, (last - first) * size, node);
+        }
+    }
+};
+
+}  // namespace multiqueue::numa
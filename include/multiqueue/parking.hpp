@@ -0,0 +1,126 @@
+/**
+******************************************************************************
+* @file:   parking.hpp
+*
+* @brief:  Parking of idle handles and termination detection
+*******************************************************************************
+**/
+
+#pragma once
+
+#include "multiqueue/build_config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace multiqueue {
+
+// Handles that find the multiqueue empty can park here until new elements are pushed. When all registered handles
+// are parked and the multiqueue is empty, no handle can produce new elements anymore and the multiqueue is considered
+// terminated. Handles that are not registered yet or already deregistered are not waited for. Once terminated, all
+// parked handles are released and parking fails immediately until new elements are pushed.
+//
+// Pushing handles only pay for a relaxed load of the sleeper count unless there are sleepers. A lost wake-up is
+// prevented by the sleeper registering itself before checking every queue under its lock: A concurrent push either
+// releases its queue lock before the sleeper acquires it (and the sleeper sees the element), or acquires it afterwards
+// (and sees the sleeper).
+class Parking {
+    alignas(build_config::l1_cache_line_size) std::atomic<std::size_t> num_sleeping_{0};
+    alignas(build_config::l1_cache_line_size) std::atomic<std::size_t> num_handles_{0};
+    std::atomic_bool terminated_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // Must be called with the mutex held after registering as sleeper. Returns true if the caller should sleep.
+    template <typename IsEmpty>
+    bool prepare_sleep(IsEmpty &&is_empty) {
+        if (!is_empty()) {
+            return false;
+        }
+        if (num_sleeping_.load(std::memory_order_relaxed) == num_handles_.load(std::memory_order_relaxed)) {
+            terminated_.store(true, std::memory_order_relaxed);
+            cv_.notify_all();
+            return false;
+        }
+        return true;
+    }
+
+   public:
+    void register_handle() noexcept {
+        num_handles_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void deregister_handle() {
+        std::lock_guard lock{mutex_};
+        num_handles_.fetch_sub(1, std::memory_order_relaxed);
+        // The remaining handles might all be sleeping, so one of them has to check for termination
+        if (num_sleeping_.load(std::memory_order_relaxed) != 0) {
+            cv_.notify_one();
+        }
+    }
+
+    // Clears the termination, must be called whenever new elements are made available
+    void resume() {
+        if (terminated_.load(std::memory_order_relaxed)) {
+            std::lock_guard lock{mutex_};
+            terminated_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Must be called after the lock of the queue the elements were pushed to was acquired
+    void notify_one() {
+        resume();
+        if (num_sleeping_.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard lock{mutex_};
+            cv_.notify_one();
+        }
+    }
+
+    void notify_all() {
+        resume();
+        if (num_sleeping_.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard lock{mutex_};
+            cv_.notify_all();
+        }
+    }
+
+    // Blocks until woken up if `is_empty()` returns true. `is_empty` must lock every queue and must return false if
+    // any queue is either nonempty or could not be locked. Returns false if the multiqueue is terminated.
+    template <typename IsEmpty>
+    bool wait(IsEmpty &&is_empty) {
+        std::unique_lock lock{mutex_};
+        if (terminated()) {
+            return false;
+        }
+        num_sleeping_.fetch_add(1, std::memory_order_relaxed);
+        if (prepare_sleep(is_empty)) {
+            cv_.wait(lock);
+        }
+        num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        return !terminated();
+    }
+
+    // Same as `wait`, but also returns when `deadline` is reached
+    template <typename IsEmpty, typename Clock, typename Duration>
+    bool wait_until(IsEmpty &&is_empty, std::chrono::time_point<Clock, Duration> const &deadline) {
+        std::unique_lock lock{mutex_};
+        if (terminated()) {
+            return false;
+        }
+        num_sleeping_.fetch_add(1, std::memory_order_relaxed);
+        if (prepare_sleep(is_empty)) {
+            cv_.wait_until(lock, deadline);
+        }
+        num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        return !terminated();
+    }
+
+    [[nodiscard]] bool terminated() const noexcept {
+        return terminated_.load(std::memory_order_relaxed);
+    }
+};
+
+}  // namespace multiqueue
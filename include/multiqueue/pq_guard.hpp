@@ -11,9 +11,12 @@
 #pragma once
 
 #include "multiqueue/build_config.hpp"
+#include "multiqueue/nonempty_bitmap.hpp"
+#include "multiqueue/seqlock.hpp"
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <limits>
 #include <memory>
 #include <stdexcept>
@@ -28,11 +31,33 @@ class alignas(build_config::l1_cache_line_size) PQGuard {
     using priority_queue_type = PriorityQueue;
     static_assert(std::is_same_v<value_type, typename priority_queue_type::value_type>,
                   "PriorityQueue::value_type must be the same as Value");
-    static_assert(std::atomic<key_type>::is_always_lock_free, "std::atomic<key_type> must be lock-free");
-    std::atomic<key_type> top_key_ = Sentinel::sentinel();
+    static_assert(std::is_trivially_copyable_v<key_type>, "key_type must be trivially copyable");
+    // Keys that are no lock-free atomics, e.g. composite keys, are published with a sequence lock. The queue lock
+    // guarantees a single writer.
+    using top_key_type = std::conditional_t<std::atomic<key_type>::is_always_lock_free, std::atomic<key_type>,
+                                            SeqLock<key_type>>;
+
+    top_key_type top_key_ = Sentinel::sentinel();
+    NonEmptyBitmap* nonempty_{nullptr};
+    std::size_t index_{};
     alignas(build_config::l1_cache_line_size) std::atomic_bool lock_ = false;
     priority_queue_type pq_;
 
+    void set_top_key(key_type key) {
+        auto const old_key = top_key();
+        if (key == old_key) {
+            return;
+        }
+        top_key_.store(key, std::memory_order_relaxed);
+        if (nonempty_ != nullptr && Sentinel::is_sentinel(old_key) != Sentinel::is_sentinel(key)) {
+            if (Sentinel::is_sentinel(key)) {
+                nonempty_->reset(index_);
+            } else {
+                nonempty_->set(index_);
+            }
+        }
+    }
+
    public:
     explicit PQGuard() = default;
 
@@ -47,21 +72,26 @@ class alignas(build_config::l1_cache_line_size) PQGuard {
         return Sentinel::is_sentinel(top_key());
     }
 
+    // Registers the guard as queue `index` in the bitmap of nonempty queues and publishes the current top key. Must
+    // not be called concurrently with any other operation.
+    void attach(NonEmptyBitmap& nonempty, std::size_t index) {
+        nonempty_ = &nonempty;
+        index_ = index;
+        top_key_.store(Sentinel::sentinel(), std::memory_order_relaxed);
+        popped();
+    }
+
     bool try_lock() noexcept {
         // Test first but expect success
         return !(lock_.load(std::memory_order_relaxed) || lock_.exchange(true, std::memory_order_acquire));
     }
 
     void popped() {
-        auto key = (pq_.empty() ? Sentinel::sentinel() : KeyOfValue::get(pq_.top()));
-        top_key_.store(key, std::memory_order_relaxed);
+        set_top_key(pq_.empty() ? Sentinel::sentinel() : KeyOfValue::get(pq_.top()));
     }
 
     void pushed() {
-        auto key = KeyOfValue::get(pq_.top());
-        if (key != top_key()) {
-            top_key_.store(key, std::memory_order_relaxed);
-        }
+        set_top_key(KeyOfValue::get(pq_.top()));
     }
 
     void unlock() {
@@ -0,0 +1,215 @@
+/**
+******************************************************************************
+* @file:   radix_heap.hpp
+*
+* @brief:  Radix heap for integer keys that are mostly extracted in monotone
+*          order
+*******************************************************************************
+**/
+#pragma once
+
+#include "multiqueue/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace multiqueue {
+
+// A radix heap ordered by the integer keys of the values. Compare must be `std::greater` for a min-queue or
+// `std::less` for a max-queue. The keys are mapped to unsigned ranks, such that the top element has the lowest rank.
+// Bucket 0 holds the values with the rank of the last extracted value, bucket `i > 0` holds the values whose rank
+// first differs from it in bit `i - 1`. Pushing and popping thus take amortized O(log U) time for keys from a universe
+// of size U, but only if pushed values are not better than the last extracted one. Such values are pushed into a
+// binary heap instead, which is always popped first. This keeps the order exact if the keys are not monotone, e.g.,
+// because pops of a relaxed priority queue reorder them.
+template <typename Value, typename KeyOfValue = utils::Identity, typename Compare = std::greater<>>
+class RadixHeap {
+   public:
+    using value_type = Value;
+    using key_type = std::decay_t<decltype(KeyOfValue::get(std::declval<Value const &>()))>;
+    using key_compare = Compare;
+    using value_compare = utils::ValueCompare<Value, KeyOfValue, Compare>;
+    using reference = value_type &;
+    using const_reference = value_type const &;
+    using size_type = std::size_t;
+
+    static_assert(std::is_integral_v<key_type>, "The keys must be integers");
+
+   protected:
+    // NOLINTNEXTLINE(cppcoreguidelines-non-private-member-variables-in-classes): Compatibility to Heap
+    [[no_unique_address]] value_compare comp;
+
+   private:
+    using rank_type = std::make_unsigned_t<key_type>;
+    static constexpr std::size_t num_bits = std::numeric_limits<rank_type>::digits;
+    static constexpr bool max_queue =
+        std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<key_type>>;
+    static_assert(max_queue || std::is_same_v<Compare, std::greater<>> ||
+                      std::is_same_v<Compare, std::greater<key_type>>,
+                  "Compare must be std::less or std::greater");
+
+    std::array<std::vector<value_type>, num_bits + 1> buckets_;
+    // Bit `i - 1` is set if bucket `i > 0` is nonempty
+    std::uint64_t nonempty_{0};
+    // Values better than the last extracted value, as a binary heap
+    std::vector<value_type> early_;
+    rank_type last_{0};
+    size_type size_{0};
+
+    static constexpr rank_type rank(key_type key) noexcept {
+        auto r = static_cast<rank_type>(key);
+        if constexpr (std::is_signed_v<key_type>) {
+            r ^= rank_type{1} << (num_bits - 1);
+        }
+        if constexpr (max_queue) {
+            r = static_cast<rank_type>(~r);
+        }
+        return r;
+    }
+
+    static constexpr rank_type rank_of(value_type const &value) noexcept {
+        return rank(KeyOfValue::get(value));
+    }
+
+    [[nodiscard]] std::size_t bucket(rank_type r) const noexcept {
+        assert(r >= last_);
+        if (r == last_) {
+            return 0;
+        }
+        return static_cast<std::size_t>(64 - __builtin_clzll(static_cast<std::uint64_t>(r ^ last_)));
+    }
+
+    template <typename V>
+    void insert(V &&value) {
+        auto const r = rank_of(value);
+        if (size_ == 0) {
+            last_ = r;
+        }
+        if (r < last_) {
+            early_.push_back(std::forward<V>(value));
+            std::push_heap(early_.begin(), early_.end(), comp);
+        } else {
+            auto const b = bucket(r);
+            buckets_[b].push_back(std::forward<V>(value));
+            if (b != 0) {
+                nonempty_ |= std::uint64_t{1} << (b - 1);
+            }
+        }
+        ++size_;
+    }
+
+    // Moves the values of the first nonempty bucket into the lower buckets, such that bucket 0 becomes nonempty
+    void refill() {
+        assert(buckets_[0].empty());
+        if (nonempty_ == 0) {
+            return;
+        }
+        auto const b = static_cast<std::size_t>(__builtin_ctzll(nonempty_)) + 1;
+        nonempty_ &= nonempty_ - 1;
+        auto &source = buckets_[b];
+        last_ = std::numeric_limits<rank_type>::max();
+        for (auto const &value : source) {
+            last_ = std::min(last_, rank_of(value));
+        }
+        for (auto &value : source) {
+            auto const target = bucket(rank_of(value));
+            assert(target < b);
+            buckets_[target].push_back(std::move(value));
+            if (target != 0) {
+                nonempty_ |= std::uint64_t{1} << (target - 1);
+            }
+        }
+        source.clear();
+    }
+
+   public:
+    explicit RadixHeap(value_compare const &compare = value_compare()) : comp{compare} {
+    }
+
+    template <typename InputIt>
+    RadixHeap(InputIt first, InputIt last, value_compare const &compare = value_compare()) : comp{compare} {
+        push_range(first, last);
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr size_type size() const noexcept {
+        return size_;
+    }
+
+    constexpr const_reference top() const {
+        assert(!empty());
+        return early_.empty() ? buckets_[0].back() : early_.front();
+    }
+
+    void pop() {
+        assert(!empty());
+        --size_;
+        if (!early_.empty()) {
+            std::pop_heap(early_.begin(), early_.end(), comp);
+            early_.pop_back();
+            return;
+        }
+        buckets_[0].pop_back();
+        if (buckets_[0].empty()) {
+            refill();
+        }
+    }
+
+    // Removes the top element and returns it by moving it out of the heap
+    value_type extract_top() {
+        assert(!empty());
+        value_type value = std::move(early_.empty() ? buckets_[0].back() : early_.front());
+        pop();
+        return value;
+    }
+
+    void push(const_reference value) {
+        insert(value);
+    }
+
+    void push(value_type &&value) {
+        insert(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template <typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    void clear() noexcept {
+        for (auto &b : buckets_) {
+            b.clear();
+        }
+        early_.clear();
+        nonempty_ = 0;
+        size_ = 0;
+    }
+
+    // The buckets grow on demand, since the distribution of the values over the buckets is not known in advance
+    void reserve(size_type /*new_cap*/) noexcept {
+    }
+
+    constexpr value_compare value_comp() const {
+        return comp;
+    }
+};
+
+}  // namespace multiqueue
@@ -51,4 +51,27 @@ struct Implicit {
     }
 };
 
+// Uses `value` as sentinel, which must not be a valid key. Unlike with `Implicit`, the sentinel compares worse than
+// all keys regardless of its value, e.g. the maximum of an unsigned type in a max-queue.
+template <typename T, typename Compare, T value>
+struct Explicit {
+    static constexpr T sentinel() noexcept {
+        return value;
+    }
+
+    static constexpr bool is_sentinel(T const& t) noexcept {
+        return t == value;
+    }
+
+    static constexpr bool compare(Compare const& comp, T const& lhs, T const& rhs) noexcept {
+        if (is_sentinel(rhs)) {
+            return false;
+        }
+        if (is_sentinel(lhs)) {
+            return true;
+        }
+        return comp(lhs, rhs);
+    }
+};
+
 }  // namespace multiqueue::sentinel
@@ -0,0 +1,79 @@
+/**
+******************************************************************************
+* @file:   seqlock.hpp
+*
+* @brief:  Single-writer sequence lock for values that are not lock-free
+*          atomics
+*******************************************************************************
+**/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace multiqueue {
+
+// Stores a trivially copyable value that can be read concurrently to a single writer without locking. The value is
+// kept in relaxed atomic words, so torn reads are data-race free and detected by the sequence number. Readers never
+// block the writer and only retry while a store is in progress. The interface mirrors the subset of `std::atomic` used
+// by the guards; the memory order arguments are ignored.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+    using word_type = std::uint64_t;
+    static constexpr std::size_t num_words = (sizeof(T) + sizeof(word_type) - 1) / sizeof(word_type);
+
+    std::atomic<std::uint32_t> seq_{0};
+    std::array<std::atomic<word_type>, num_words> words_{};
+
+    void write_words(T const &value) noexcept {
+        std::array<word_type, num_words> buffer{};
+        std::memcpy(buffer.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < num_words; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+    }
+
+   public:
+    // Not explicit, like the constructor of std::atomic
+    SeqLock(T const &value) noexcept {
+        write_words(value);
+    }
+
+    SeqLock(SeqLock const &) = delete;
+    SeqLock &operator=(SeqLock const &) = delete;
+
+    [[nodiscard]] T load(std::memory_order /*order*/ = std::memory_order_seq_cst) const noexcept {
+        std::array<word_type, num_words> buffer;
+        std::uint32_t seq{};
+        do {
+            seq = seq_.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < num_words; ++i) {
+                buffer[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != seq_.load(std::memory_order_relaxed));
+        // T need not be default constructible, so the value is copied into raw storage instead
+        alignas(T) unsigned char value[sizeof(T)];
+        std::memcpy(value, buffer.data(), sizeof(T));
+        return *std::launder(reinterpret_cast<T const *>(value));
+    }
+
+    // Must not be called concurrently with another store
+    void store(T const &value, std::memory_order /*order*/ = std::memory_order_seq_cst) noexcept {
+        auto const seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        write_words(value);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+};
+
+}  // namespace multiqueue
@@ -0,0 +1,261 @@
+/**
+******************************************************************************
+* @file:   sequence_heap.hpp
+*
+* @brief:  Cache-efficient priority queue merging sorted runs
+*******************************************************************************
+**/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace multiqueue {
+
+// A sequence heap (Sanders, 2000) for large queues. New values are pushed into a small binary insertion heap. When it
+// is full, it is sorted into a run, and runs are merged `merge_width` at a time into longer runs of the next group.
+// Values are extracted from a deletion buffer that is refilled by a k-way merge of all runs. All accesses except the
+// ones to the insertion heap are sequential, so the queue stays cache-efficient for sizes far beyond the cache.
+// Runs and the deletion buffer are sorted such that their best value is at the back.
+template <typename T, typename Compare = std::less<>, std::size_t insertion_capacity = 256,
+          std::size_t merge_width = 16>
+class SequenceHeap {
+    static_assert(insertion_capacity >= 1, "The insertion heap must hold at least one value");
+    static_assert(merge_width >= 2, "At least two runs must be merged at a time");
+
+   public:
+    using value_type = T;
+    using value_compare = Compare;
+    using reference = value_type &;
+    using const_reference = value_type const &;
+    using size_type = std::size_t;
+
+   protected:
+    // NOLINTNEXTLINE(cppcoreguidelines-non-private-member-variables-in-classes): Compatibility to Heap
+    [[no_unique_address]] value_compare comp;
+
+   private:
+    using run_type = std::vector<value_type>;
+
+    std::vector<value_type> insertion_heap_;
+    // Better than every value in the runs
+    run_type deletion_buffer_;
+    // Group `i` holds at most `merge_width` runs
+    std::vector<std::vector<run_type>> groups_;
+    size_type size_{0};
+
+    [[nodiscard]] bool better(value_type const &lhs, value_type const &rhs) const {
+        return comp(rhs, lhs);
+    }
+
+    // Merges the runs into `out` with the best value at the back. At most `max_count` values are moved and removed
+    // from the backs of the runs.
+    void merge(std::vector<run_type *> const &runs, run_type &out, size_type max_count) {
+        // Heap of the runs ordered by their best value
+        auto run_comp = [this](run_type const *lhs, run_type const *rhs) { return comp(lhs->back(), rhs->back()); };
+        std::vector<run_type *> cursors;
+        cursors.reserve(runs.size());
+        for (auto *r : runs) {
+            if (!r->empty()) {
+                cursors.push_back(r);
+            }
+        }
+        std::make_heap(cursors.begin(), cursors.end(), run_comp);
+        auto const first = out.size();
+        while (!cursors.empty() && out.size() - first < max_count) {
+            std::pop_heap(cursors.begin(), cursors.end(), run_comp);
+            auto *r = cursors.back();
+            out.push_back(std::move(r->back()));
+            r->pop_back();
+            if (r->empty()) {
+                cursors.pop_back();
+            } else {
+                std::push_heap(cursors.begin(), cursors.end(), run_comp);
+            }
+        }
+        std::reverse(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+    }
+
+    // Adds a run to group `g`, merging the group into the next one if it is full
+    void add_run(std::size_t g, run_type &&run) {
+        if (g == groups_.size()) {
+            groups_.emplace_back();
+        }
+        groups_[g].push_back(std::move(run));
+        if (groups_[g].size() <= merge_width) {
+            return;
+        }
+        std::vector<run_type *> runs;
+        size_type total = 0;
+        for (auto &r : groups_[g]) {
+            runs.push_back(&r);
+            total += r.size();
+        }
+        run_type merged;
+        merged.reserve(total);
+        merge(runs, merged, total);
+        groups_[g].clear();
+        add_run(g + 1, std::move(merged));
+    }
+
+    // Sorts the insertion heap into a new run. Values better than the worst value of the deletion buffer are
+    // exchanged with the deletion buffer to keep it better than all runs.
+    void flush_insertion_heap() {
+        std::sort_heap(insertion_heap_.begin(), insertion_heap_.end(), comp);
+        run_type run;
+        if (deletion_buffer_.empty()) {
+            run = std::move(insertion_heap_);
+        } else {
+            // Both are sorted with the best value at the back, so the merged sequence splits into the new run at the
+            // front and the new deletion buffer at the back
+            run_type merged;
+            merged.reserve(insertion_heap_.size() + deletion_buffer_.size());
+            std::merge(std::make_move_iterator(insertion_heap_.begin()), std::make_move_iterator(insertion_heap_.end()),
+                       std::make_move_iterator(deletion_buffer_.begin()),
+                       std::make_move_iterator(deletion_buffer_.end()), std::back_inserter(merged), comp);
+            auto const split = merged.end() - static_cast<std::ptrdiff_t>(deletion_buffer_.size());
+            deletion_buffer_.assign(std::make_move_iterator(split), std::make_move_iterator(merged.end()));
+            merged.erase(split, merged.end());
+            run = std::move(merged);
+        }
+        insertion_heap_.clear();
+        add_run(0, std::move(run));
+        if (deletion_buffer_.empty()) {
+            refill_deletion_buffer();
+        }
+    }
+
+    void refill_deletion_buffer() {
+        assert(deletion_buffer_.empty());
+        std::vector<run_type *> runs;
+        for (auto &group : groups_) {
+            for (auto &r : group) {
+                runs.push_back(&r);
+            }
+        }
+        merge(runs, deletion_buffer_, insertion_capacity);
+        for (auto &group : groups_) {
+            group.erase(std::remove_if(group.begin(), group.end(), [](run_type const &r) { return r.empty(); }),
+                        group.end());
+        }
+    }
+
+    template <typename V>
+    void insert(V &&value) {
+        if (insertion_heap_.size() == insertion_capacity) {
+            flush_insertion_heap();
+        }
+        insertion_heap_.push_back(std::forward<V>(value));
+        std::push_heap(insertion_heap_.begin(), insertion_heap_.end(), comp);
+        ++size_;
+    }
+
+    [[nodiscard]] bool top_in_insertion_heap() const {
+        return deletion_buffer_.empty() ||
+               (!insertion_heap_.empty() && better(insertion_heap_.front(), deletion_buffer_.back()));
+    }
+
+    void pop_insertion_heap() {
+        std::pop_heap(insertion_heap_.begin(), insertion_heap_.end(), comp);
+        insertion_heap_.pop_back();
+        --size_;
+    }
+
+    void pop_deletion_buffer() {
+        deletion_buffer_.pop_back();
+        --size_;
+        if (deletion_buffer_.empty()) {
+            refill_deletion_buffer();
+        }
+    }
+
+   public:
+    explicit SequenceHeap(value_compare const &compare = value_compare()) : comp{compare} {
+    }
+
+    template <typename InputIt>
+    SequenceHeap(InputIt first, InputIt last, value_compare const &compare = value_compare()) : comp{compare} {
+        push_range(first, last);
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr size_type size() const noexcept {
+        return size_;
+    }
+
+    constexpr const_reference top() const {
+        assert(!empty());
+        return top_in_insertion_heap() ? insertion_heap_.front() : deletion_buffer_.back();
+    }
+
+    void pop() {
+        assert(!empty());
+        if (top_in_insertion_heap()) {
+            pop_insertion_heap();
+        } else {
+            pop_deletion_buffer();
+        }
+    }
+
+    // Removes the top element and returns it by moving it out of the heap
+    value_type extract_top() {
+        assert(!empty());
+        if (top_in_insertion_heap()) {
+            std::pop_heap(insertion_heap_.begin(), insertion_heap_.end(), comp);
+            value_type value = std::move(insertion_heap_.back());
+            insertion_heap_.pop_back();
+            --size_;
+            return value;
+        }
+        value_type value = std::move(deletion_buffer_.back());
+        pop_deletion_buffer();
+        return value;
+    }
+
+    void push(const_reference value) {
+        insert(value);
+    }
+
+    void push(value_type &&value) {
+        insert(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args &&...args) {
+        insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template <typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    void clear() noexcept {
+        insertion_heap_.clear();
+        deletion_buffer_.clear();
+        groups_.clear();
+        size_ = 0;
+    }
+
+    // Only the insertion heap and the deletion buffer have a fixed capacity, the runs are allocated when merging
+    void reserve(size_type /*new_cap*/) {
+        insertion_heap_.reserve(insertion_capacity);
+        deletion_buffer_.reserve(insertion_capacity);
+    }
+
+    constexpr value_compare value_comp() const {
+        return comp;
+    }
+};
+
+}  // namespace multiqueue
@@ -0,0 +1,84 @@
+/**
+******************************************************************************
+* @file:   size_counter.hpp
+*
+* @brief:  Sharded element counter
+*******************************************************************************
+**/
+
+#pragma once
+
+#include "multiqueue/build_config.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace multiqueue {
+
+// Counts the elements in the multiqueue with one counter per handle. Each counter is only written by its owning
+// handle, so updating it is an uncontended load and store on a local cache line. The counters are only summed up when
+// the size is requested. The sum is exact if no operations are in flight. Counters of destroyed handles are kept and
+// reused by new handles.
+class SizeCounter {
+   public:
+    class alignas(build_config::l1_cache_line_size) Slot {
+        friend SizeCounter;
+
+        std::atomic<std::int64_t> value_{0};
+        bool in_use_{false};
+
+       public:
+        void add(std::int64_t n) noexcept {
+            value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    };
+
+   private:
+    std::atomic<std::int64_t> base_{0};
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+
+   public:
+    Slot *acquire_slot() {
+        std::lock_guard lock{mutex_};
+        auto it = std::find_if(slots_.begin(), slots_.end(), [](auto const &s) { return !s->in_use_; });
+        if (it == slots_.end()) {
+            slots_.push_back(std::make_unique<Slot>());
+            it = std::prev(slots_.end());
+        }
+        (*it)->in_use_ = true;
+        return it->get();
+    }
+
+    void release_slot(Slot *slot) {
+        std::lock_guard lock{mutex_};
+        slot->in_use_ = false;
+    }
+
+    // Sets the size to `n`. Must not be called concurrently with any handle operation.
+    void reset(std::size_t n) {
+        std::lock_guard lock{mutex_};
+        for (auto &s : slots_) {
+            s->value_.store(0, std::memory_order_relaxed);
+        }
+        base_.store(static_cast<std::int64_t>(n), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        std::lock_guard lock{mutex_};
+        std::int64_t sum = base_.load(std::memory_order_relaxed);
+        for (auto const &s : slots_) {
+            sum += s->value_.load(std::memory_order_relaxed);
+        }
+        // Concurrent pops can be counted before the corresponding pushes
+        return static_cast<std::size_t>(std::max(sum, std::int64_t{0}));
+    }
+};
+
+}  // namespace multiqueue
@@ -0,0 +1,224 @@
+/**
+******************************************************************************
+* @file:   stats.hpp
+*
+* @brief:  Optional per-handle operation statistics
+*
+* Statistics are enabled by `static constexpr bool collect_stats = true` in the
+* policy. If disabled (the default), the recorder is an empty type and all
+* counting compiles to nothing.
+*******************************************************************************
+**/
+
+#pragma once
+
+#include "multiqueue/build_config.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace multiqueue {
+
+// Operation counts summed up over all handles
+struct OperationStats {
+    // Number of pushed and popped elements
+    std::uint64_t pushes{};
+    std::uint64_t pops{};
+    // Failed attempts to lock a queue in the mode
+    std::uint64_t failed_locks{};
+    // Pops of the mode that locked an empty queue
+    std::uint64_t empty_pops{};
+    // Pops of the mode that were retried because the top key changed before the queue was locked
+    std::uint64_t stale_pops{};
+    // Pops that fell back to scanning all queues
+    std::uint64_t scans{};
+    // Resampled sticky queues, either because the stickiness ran out or the queues could not be used
+    std::uint64_t stick_resets{};
+
+    OperationStats &operator+=(OperationStats const &other) noexcept {
+        pushes += other.pushes;
+        pops += other.pops;
+        failed_locks += other.failed_locks;
+        empty_pops += other.empty_pops;
+        stale_pops += other.stale_pops;
+        scans += other.scans;
+        stick_resets += other.stick_resets;
+        return *this;
+    }
+
+    // Writes the counts as a single-line JSON object
+    void write_json(std::ostream &out) const {
+        out << "{\"pushes\":" << pushes << ",\"pops\":" << pops << ",\"failed_locks\":" << failed_locks
+            << ",\"empty_pops\":" << empty_pops << ",\"stale_pops\":" << stale_pops << ",\"scans\":" << scans
+            << ",\"stick_resets\":" << stick_resets << '}';
+    }
+};
+
+namespace stats {
+
+template <typename Policy, typename = void>
+struct is_enabled : std::false_type {};
+
+template <typename Policy>
+struct is_enabled<Policy, std::void_t<decltype(Policy::collect_stats)>> : std::bool_constant<Policy::collect_stats> {};
+
+// The counters of a single handle. They are only written by the owning handle, so a relaxed load and store suffices.
+class alignas(build_config::l1_cache_line_size) Counters {
+   public:
+    enum class Event : std::size_t { push, pop, failed_lock, empty_pop, stale_pop, scan, stick_reset, num_events };
+
+   private:
+    std::atomic<std::uint64_t> counts_[static_cast<std::size_t>(Event::num_events)]{};
+
+    [[nodiscard]] std::uint64_t get(Event e) const noexcept {
+        return counts_[static_cast<std::size_t>(e)].load(std::memory_order_relaxed);
+    }
+
+   public:
+    void add(Event e, std::uint64_t n) noexcept {
+        auto &count = counts_[static_cast<std::size_t>(e)];
+        count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] OperationStats snapshot() const noexcept {
+        OperationStats s;
+        s.pushes = get(Event::push);
+        s.pops = get(Event::pop);
+        s.failed_locks = get(Event::failed_lock);
+        s.empty_pops = get(Event::empty_pop);
+        s.stale_pops = get(Event::stale_pop);
+        s.scans = get(Event::scan);
+        s.stick_resets = get(Event::stick_reset);
+        return s;
+    }
+};
+
+// Records the events of a handle. The modes get the recorder of the handle passed to every operation.
+template <bool Enabled>
+class Recorder {
+    using Event = Counters::Event;
+
+    Counters *counters_{nullptr};
+
+   public:
+    Recorder() = default;
+
+    explicit Recorder(Counters *counters) noexcept : counters_{counters} {
+    }
+
+    [[nodiscard]] Counters *counters() const noexcept {
+        return counters_;
+    }
+
+    void pushed(std::uint64_t n) noexcept {
+        counters_->add(Event::push, n);
+    }
+
+    void popped(std::uint64_t n) noexcept {
+        counters_->add(Event::pop, n);
+    }
+
+    void failed_lock() noexcept {
+        counters_->add(Event::failed_lock, 1);
+    }
+
+    void empty_pop() noexcept {
+        counters_->add(Event::empty_pop, 1);
+    }
+
+    void stale_pop() noexcept {
+        counters_->add(Event::stale_pop, 1);
+    }
+
+    void scan() noexcept {
+        counters_->add(Event::scan, 1);
+    }
+
+    void stick_reset() noexcept {
+        counters_->add(Event::stick_reset, 1);
+    }
+};
+
+template <>
+class Recorder<false> {
+   public:
+    void pushed(std::uint64_t /*n*/) noexcept {
+    }
+
+    void popped(std::uint64_t /*n*/) noexcept {
+    }
+
+    void failed_lock() noexcept {
+    }
+
+    void empty_pop() noexcept {
+    }
+
+    void stale_pop() noexcept {
+    }
+
+    void scan() noexcept {
+    }
+
+    void stick_reset() noexcept {
+    }
+};
+
+// Owns the counters of all handles. Counters of destroyed handles are kept and reused by new handles, so that their
+// counts are still part of the snapshot.
+template <bool Enabled>
+class Registry {
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Counters>> counters_;
+    std::vector<Counters *> free_;
+
+   public:
+    Recorder<true> acquire() {
+        std::lock_guard lock{mutex_};
+        if (!free_.empty()) {
+            auto *c = free_.back();
+            free_.pop_back();
+            return Recorder<true>{c};
+        }
+        counters_.push_back(std::make_unique<Counters>());
+        return Recorder<true>{counters_.back().get()};
+    }
+
+    void release(Recorder<true> const &recorder) {
+        std::lock_guard lock{mutex_};
+        free_.push_back(recorder.counters());
+    }
+
+    [[nodiscard]] OperationStats snapshot() const {
+        std::lock_guard lock{mutex_};
+        OperationStats s;
+        for (auto const &c : counters_) {
+            s += c->snapshot();
+        }
+        return s;
+    }
+};
+
+template <>
+class Registry<false> {
+   public:
+    Recorder<false> acquire() noexcept {
+        return {};
+    }
+
+    void release(Recorder<false> const & /*recorder*/) noexcept {
+    }
+
+    [[nodiscard]] OperationStats snapshot() const noexcept {
+        return {};
+    }
+};
+
+}  // namespace stats
+}  // namespace multiqueue
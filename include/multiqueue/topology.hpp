@@ -0,0 +1,101 @@
+/**
+******************************************************************************
+* @file:   topology.hpp
+*
+* @brief:  Cache domains of the cpus, read from sysfs
+*
+* On systems other than Linux, or if sysfs does not describe the caches, all
+* cpus are treated as a single cache domain.
+*******************************************************************************
+**/
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace multiqueue::topology {
+
+// Returns the cpu the calling thread currently runs on
+inline int current_cpu() noexcept {
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : cpu;
+#else
+    return 0;
+#endif
+}
+
+// Groups the cpus by the cache of the given level they share. Each cpu list in sysfs is identified by its first cpu,
+// e.g. "0-3,64-67" by cpu 0, so that SMT siblings with distant numbers end up in the same domain.
+class CacheDomains {
+    std::vector<int> domain_of_cpu_;
+    int num_domains_{1};
+
+    // Returns the first cpu of the list of cpus sharing the cache of `level` with `cpu`, or -1 if it is not known
+    static int first_sharing_cpu(int cpu, int level) {
+        auto const cpu_dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index";
+        for (int index = 0;; ++index) {
+            std::ifstream level_file(cpu_dir + std::to_string(index) + "/level");
+            if (!level_file) {
+                return -1;
+            }
+            int cache_level = 0;
+            level_file >> cache_level;
+            if (cache_level != level) {
+                continue;
+            }
+            std::ifstream list_file(cpu_dir + std::to_string(index) + "/shared_cpu_list");
+            int first = -1;
+            if (!(list_file >> first)) {
+                return -1;
+            }
+            return first;
+        }
+    }
+
+   public:
+    // Reads the domains of all cpus. If any cpu is not described, all cpus form a single domain.
+    explicit CacheDomains(int level) {
+        auto const num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_cpus <= 0) {
+            return;
+        }
+        std::vector<int> id_of_first(static_cast<std::size_t>(num_cpus), -1);
+        domain_of_cpu_.resize(static_cast<std::size_t>(num_cpus));
+        num_domains_ = 0;
+        for (int cpu = 0; cpu < num_cpus; ++cpu) {
+            auto const first = first_sharing_cpu(cpu, level);
+            if (first < 0 || first >= num_cpus) {
+                domain_of_cpu_.clear();
+                num_domains_ = 1;
+                return;
+            }
+            auto &id = id_of_first[static_cast<std::size_t>(first)];
+            if (id < 0) {
+                id = num_domains_++;
+            }
+            domain_of_cpu_[static_cast<std::size_t>(cpu)] = id;
+        }
+    }
+
+    [[nodiscard]] int num_domains() const noexcept {
+        return num_domains_;
+    }
+
+    // Cpus not known at construction are mapped to domain 0
+    [[nodiscard]] int domain_of(int cpu) const noexcept {
+        return cpu >= 0 && static_cast<std::size_t>(cpu) < domain_of_cpu_.size()
+                   ? domain_of_cpu_[static_cast<std::size_t>(cpu)]
+                   : 0;
+    }
+};
+
+}  // namespace multiqueue::topology
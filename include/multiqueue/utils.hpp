@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+#include <type_traits>
 #include <utility>
 
 namespace multiqueue::utils {
@@ -27,4 +29,13 @@ struct ValueCompare {
     }
 };
 
+// The comparators for which the best of several keys is their minimum or maximum
+template <typename T, typename Compare>
+struct is_min_max_compare
+    : std::bool_constant<std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>> ||
+                         std::is_same_v<Compare, std::greater<T>> || std::is_same_v<Compare, std::greater<>>> {};
+
+template <typename T, typename Compare>
+struct is_min_max_compare<T, ValueCompare<T, Identity, Compare>> : is_min_max_compare<T, Compare> {};
+
 }  // namespace multiqueue::utils
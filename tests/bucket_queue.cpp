@@ -0,0 +1,70 @@
+#include "multiqueue/bucket_queue.hpp"
+#include "multiqueue/buffered_pq.hpp"
+#include "multiqueue/utils.hpp"
+#include "test_types.hpp"
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+
+TEMPLATE_TEST_CASE("bucket queue pops in order", "[bucket_queue]", std::greater<>, std::less<>) {
+    auto run = [](auto pq, int num_keys) {
+        auto gen = std::mt19937{0};
+        auto dist = std::uniform_int_distribution{0, num_keys - 1};
+        for (int s = 0; s < 2000; ++s) {
+            for (int i = 0; i < 5; ++i) {
+                pq.push(dist(gen));
+            }
+            for (int i = 0; i < 4; ++i) {
+                pq.pop();
+            }
+        }
+        pq.drain();
+    };
+    using multiqueue::BucketQueue;
+    using multiqueue::utils::Identity;
+
+    run(test_types::checked_pq<BucketQueue<int, Identity, TestType>, TestType>{}, 4096);
+    run(test_types::checked_pq<BucketQueue<int, Identity, TestType>, TestType>{}, 10);
+    // Sparse buckets span several summary words
+    run(test_types::checked_pq<BucketQueue<int, Identity, TestType, 1 << 14>, TestType>{}, 1 << 14);
+    run(test_types::checked_pq<BucketQueue<int, Identity, TestType, 1>, TestType>{}, 1);
+    run(test_types::checked_pq<multiqueue::BufferedPQ<BucketQueue<int, Identity, TestType>>, TestType>{}, 4096);
+}
+
+TEST_CASE("bucket queue finds buckets far apart", "[bucket_queue]") {
+    auto pq = multiqueue::BucketQueue<std::uint32_t, multiqueue::utils::Identity, std::greater<>, 1 << 14>{};
+    pq.push((1U << 14) - 1);
+    pq.push(0);
+    pq.push(4095);
+    pq.push(4096);
+    for (auto key : {0U, 4095U, 4096U, (1U << 14) - 1}) {
+        REQUIRE(pq.top() == key);
+        pq.pop();
+    }
+    REQUIRE(pq.empty());
+    pq.push(7);
+    pq.clear();
+    REQUIRE(pq.empty());
+    pq.push(9);
+    REQUIRE(pq.top() == 9);
+}
+
+TEST_CASE("bucket queue stores key-value pairs", "[bucket_queue][types]") {
+    using value_type = std::pair<int, std::string>;
+    auto pq = multiqueue::BucketQueue<value_type, multiqueue::utils::PairFirst, std::less<>, 100>{};
+    for (int i = 0; i < 100; ++i) {
+        pq.emplace(i * 37 % 100, std::to_string(i * 37 % 100));
+    }
+    for (int i = 99; i >= 0; --i) {
+        auto v = pq.extract_top();
+        REQUIRE(v.first == i);
+        REQUIRE(v.second == std::to_string(i));
+    }
+    REQUIRE(pq.empty());
+}
@@ -1,11 +1,16 @@
 #include "multiqueue/buffered_pq.hpp"
 #include "multiqueue/heap.hpp"
+#include "test_types.hpp"
 
 #include "catch2/catch_template_test_macros.hpp"
 #include "catch2/generators/catch_generators_all.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <functional>
 #include <list>
+#include <numeric>
 #include <queue>
 #include <random>
 #include <type_traits>
@@ -186,3 +191,140 @@ TEST_CASE("buffered pq works with randomized workloads", "[buffered_pq][workload
         REQUIRE(ref_pq.empty());
     }
 }
+
+TEST_CASE("buffered pq works with move-only types", "[buffered_pq][types]") {
+    using pq_t = multiqueue::BufferedPQ<multiqueue::Heap<test_types::nocopy, std::less<>>>;
+
+    auto pq = pq_t{};
+    for (int i = 0; i < 1000; ++i) {
+        test_types::nocopy t;
+        t.i = i * 7 % 1000;
+        pq.push(std::move(t));
+    }
+    for (int i = 999; i >= 0; --i) {
+        REQUIRE(pq.top().i == i);
+        REQUIRE(pq.extract_top().i == i);
+    }
+    REQUIRE(pq.empty());
+}
+
+TEST_CASE("buffered pq supports bulk insertion", "[buffered_pq][bulk]") {
+    using pq_t = multiqueue::BufferedPQ<multiqueue::Heap<int>>;
+
+    auto pq = pq_t{};
+    auto ref_pq = std::priority_queue<int>{};
+    auto gen = std::mt19937{0};
+    auto dist = std::uniform_int_distribution{-1000, 1000};
+
+    for (int s = 0; s < 100; ++s) {
+        for (int i = 0; i < 5; ++i) {
+            auto n = dist(gen);
+            pq.push(n);
+            ref_pq.push(n);
+        }
+        std::vector<int> values(static_cast<std::size_t>(s));
+        std::generate(values.begin(), values.end(), [&] { return dist(gen); });
+        pq.push_range(values.begin(), values.end());
+        std::for_each(values.begin(), values.end(), [&](int v) { ref_pq.push(v); });
+        REQUIRE(pq.size() == ref_pq.size());
+        for (int i = 0; i < 10 && !ref_pq.empty(); ++i) {
+            REQUIRE(pq.top() == ref_pq.top());
+            pq.pop();
+            ref_pq.pop();
+        }
+    }
+    while (!pq.empty()) {
+        REQUIRE(pq.top() == ref_pq.top());
+        pq.pop();
+        ref_pq.pop();
+    }
+    REQUIRE(ref_pq.empty());
+}
+
+TEMPLATE_TEST_CASE_SIG("sorting network sorts all permutations", "[buffered_pq][sort]", ((std::size_t N), N), 1, 2, 3,
+                       5, 8) {
+    auto values = std::array<int, N>{};
+    std::iota(values.begin(), values.end(), 0);
+    do {
+        auto sorted = values;
+        multiqueue::detail::sort_network<N>(sorted.data(), std::less<>{});
+        REQUIRE(std::is_sorted(sorted.begin(), sorted.end()));
+    } while (std::next_permutation(values.begin(), values.end()));
+
+    // Random values with duplicates for larger sizes
+    auto gen = std::mt19937{0};
+    auto dist = std::uniform_int_distribution{0, 10};
+    auto large = std::array<int, 4 * N + 3>{};
+    for (int i = 0; i < 100; ++i) {
+        std::generate(large.begin(), large.end(), [&]() { return dist(gen); });
+        multiqueue::detail::sort_network<4 * N + 3>(large.data(), std::greater<>{});
+        REQUIRE(std::is_sorted(large.begin(), large.end(), std::greater<>{}));
+    }
+}
+
+TEST_CASE("buffered pq merges the insertion buffer into the deletion buffer", "[buffered_pq][refill]") {
+    using pq_t = multiqueue::BufferedPQ<multiqueue::Heap<int>, 8, 4>;
+    auto pq = pq_t{};
+    // The deletion buffer takes the first values, the next ones are worse and stay in the insertion buffer
+    for (int n : {100, 101, 102, 103, 5, 50, 7, 60, 3, 99, 1, 2}) {
+        pq.push(n);
+    }
+    for (int n : {103, 102, 101, 100, 99, 60, 50, 7, 5, 3, 2, 1}) {
+        REQUIRE(pq.top() == n);
+        pq.pop();
+    }
+    REQUIRE(pq.empty());
+}
+
+TEST_CASE("buffered pq adapts its buffer capacities", "[buffered_pq][adaptive]") {
+    using pq_t = multiqueue::BufferedPQ<multiqueue::Heap<int, std::greater<>>, 64, 64,
+                                        multiqueue::AdaptiveBufferedPQOptions>;
+
+    SECTION("randomized workloads") {
+        auto pq = pq_t{};
+        auto ref_pq = std::priority_queue<int, std::vector<int>, std::greater<>>{};
+        auto gen = std::mt19937{0};
+        auto dist = std::uniform_int_distribution{0, 1000};
+        // Alternating push-heavy and pop-heavy phases
+        for (int phase = 0; phase < 8; ++phase) {
+            auto const push_probability = phase % 2 == 0 ? 0.9 : 0.2;
+            auto coin = std::bernoulli_distribution{push_probability};
+            for (int i = 0; i < 5000; ++i) {
+                if (ref_pq.empty() || coin(gen)) {
+                    auto n = dist(gen);
+                    pq.push(n);
+                    ref_pq.push(n);
+                } else {
+                    REQUIRE(pq.top() == ref_pq.top());
+                    pq.pop();
+                    ref_pq.pop();
+                }
+                REQUIRE(pq.size() == ref_pq.size());
+                REQUIRE(pq.insertion_capacity() >= 4);
+                REQUIRE(pq.insertion_capacity() <= 64);
+                REQUIRE(pq.deletion_capacity() >= 4);
+                REQUIRE(pq.deletion_capacity() <= 64);
+            }
+        }
+        while (!pq.empty()) {
+            REQUIRE(pq.top() == ref_pq.top());
+            pq.pop();
+            ref_pq.pop();
+        }
+        REQUIRE(ref_pq.empty());
+    }
+
+    SECTION("capacities follow the push/pop ratio") {
+        auto pq = pq_t{};
+        REQUIRE(pq.insertion_capacity() == 16);
+        REQUIRE(pq.deletion_capacity() == 16);
+        for (int i = 0; i < 10'000; ++i) {
+            pq.push(10'000 - i);
+        }
+        REQUIRE(pq.insertion_capacity() == 64);
+        for (int i = 0; i < 5'000; ++i) {
+            pq.pop();
+        }
+        REQUIRE(pq.deletion_capacity() == 64);
+    }
+}
@@ -1,10 +1,14 @@
 #include "multiqueue/heap.hpp"
+#include "multiqueue/key_value_heap.hpp"
 #include "test_types.hpp"
 
 #include "catch2/catch_template_test_macros.hpp"
 #include "catch2/generators/catch_generators_all.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <limits>
 #include <list>
 #include <queue>
 #include <random>
@@ -60,6 +64,46 @@ TEMPLATE_TEST_CASE_SIG("heap supports basic operations", "[heap][basic]", ((unsi
     }
 }
 
+TEMPLATE_TEST_CASE_SIG("heap supports bulk insertion", "[heap][bulk]", ((unsigned int Arity), Arity), 2, 3, 4, 99) {
+    using heap_t = multiqueue::Heap<int, std::less<>, Arity>;
+
+    auto gen = std::mt19937{0};
+    auto dist = std::uniform_int_distribution{-1000, 1000};
+    std::vector<int> values(1000);
+    std::generate(values.begin(), values.end(), [&] { return dist(gen); });
+    auto ref_pq = std::priority_queue<int>{};
+
+    SECTION("construct from a range") {
+        auto heap = heap_t(values.begin(), values.end());
+        ref_pq = std::priority_queue<int>(values.begin(), values.end());
+        while (!heap.empty()) {
+            REQUIRE(heap.top() == ref_pq.top());
+            heap.pop();
+            ref_pq.pop();
+        }
+        REQUIRE(ref_pq.empty());
+    }
+
+    SECTION("push ranges of different sizes") {
+        auto heap = heap_t{};
+        std::size_t const chunks[] = {1, 1, 10, 100, 30, 400, 458};
+        auto it = values.begin();
+        for (auto chunk : chunks) {
+            heap.push_range(it, it + static_cast<std::ptrdiff_t>(chunk));
+            std::for_each(it, it + static_cast<std::ptrdiff_t>(chunk), [&](int v) { ref_pq.push(v); });
+            it += static_cast<std::ptrdiff_t>(chunk);
+            REQUIRE(heap.top() == ref_pq.top());
+        }
+        REQUIRE(it == values.end());
+        while (!heap.empty()) {
+            REQUIRE(heap.top() == ref_pq.top());
+            heap.pop();
+            ref_pq.pop();
+        }
+        REQUIRE(ref_pq.empty());
+    }
+}
+
 TEST_CASE("heap can use std::greater as comparator", "[heap][comparator]") {
     using heap_t = multiqueue::Heap<int, std::greater<>>;
 
@@ -190,6 +234,155 @@ TEST_CASE("heap works with randomized workloads", "[heap][workloads]") {
     }
 }
 
+TEMPLATE_TEST_CASE("heap selects the best child of arithmetic keys", "[heap][comparator]", int, std::uint64_t, float,
+                   double) {
+    auto run = [](auto pq) {
+        auto gen = std::mt19937{0};
+        // Few distinct values, so that children are often equal
+        auto dist = std::uniform_int_distribution{0, 50};
+        for (int s = 0; s < 200; ++s) {
+            for (int i = 0; i < 20; ++i) {
+                pq.push(static_cast<TestType>(dist(gen)));
+            }
+            for (int i = 0; i < 15; ++i) {
+                pq.pop();
+            }
+        }
+        pq.drain();
+    };
+    run(test_types::checked_pq<multiqueue::Heap<TestType, std::less<>, 8>, std::less<>>{});
+    run(test_types::checked_pq<multiqueue::Heap<TestType, std::greater<TestType>, 8>, std::greater<TestType>>{});
+    run(test_types::checked_pq<multiqueue::Heap<TestType, std::greater<>, 16>, std::greater<>>{});
+    run(test_types::checked_pq<multiqueue::Heap<TestType, std::less<TestType>, 4>, std::less<TestType>>{});
+}
+
+struct BottomUpOptions : multiqueue::DefaultHeapOptions {
+    static constexpr bool bottom_up = true;
+};
+
+TEMPLATE_TEST_CASE_SIG("heap sifts down bottom-up", "[heap][bottom_up]", ((unsigned int Arity), Arity), 2, 3, 4, 8) {
+    auto run = [](auto pq) {
+        auto gen = std::mt19937{0};
+        // Few distinct values, so that the last element often stops above the leaves
+        auto dist = std::uniform_int_distribution{0, 50};
+        for (int s = 0; s < 200; ++s) {
+            for (int i = 0; i < 20; ++i) {
+                pq.push(dist(gen));
+            }
+            for (int i = 0; i < 15; ++i) {
+                pq.pop();
+            }
+        }
+        pq.drain();
+    };
+    run(test_types::checked_pq<multiqueue::Heap<int, std::less<>, Arity, std::vector<int>, BottomUpOptions>,
+                               std::less<>>{});
+    run(test_types::checked_pq<multiqueue::Heap<double, std::greater<>, Arity, std::vector<double>, BottomUpOptions>,
+                               std::greater<>>{});
+
+    // Random keys: the last element belongs near the leaves, so fewer comparisons are needed
+    using counting_cmp = test_types::countingcmp<int>;
+    auto count_pop_comparisons = [](auto heap) {
+        auto gen = std::mt19937{0};
+        for (int i = 0; i < 10'000; ++i) {
+            heap.push(static_cast<int>(gen()));
+        }
+        counting_cmp::count = 0;
+        int last = std::numeric_limits<int>::max();
+        while (!heap.empty()) {
+            REQUIRE(heap.top() <= last);
+            last = heap.top();
+            heap.pop();
+        }
+        return counting_cmp::count;
+    };
+    auto const top_down = count_pop_comparisons(multiqueue::Heap<int, counting_cmp, Arity>{});
+    auto const bottom_up =
+        count_pop_comparisons(multiqueue::Heap<int, counting_cmp, Arity, std::vector<int>, BottomUpOptions>{});
+    REQUIRE(bottom_up < top_down);
+}
+
+TEMPLATE_TEST_CASE_SIG("aligned heap starts sibling groups on a cache line", "[heap][aligned]",
+                       ((unsigned int Arity), Arity), 2, 4, 8) {
+    using heap_t = multiqueue::AlignedHeap<std::uint64_t, std::greater<>, Arity>;
+    static constexpr auto line_size = multiqueue::build_config::l1_cache_line_size;
+
+    auto heap = heap_t{};
+    auto ref_pq = std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<>>{};
+    auto gen = std::mt19937_64{0};
+    for (int s = 0; s < 100; ++s) {
+        for (int i = 0; i < 200; ++i) {
+            auto n = gen();
+            heap.push(n);
+            ref_pq.push(n);
+        }
+        // The children of the root follow the root
+        auto const children = reinterpret_cast<std::uintptr_t>(&heap.top() + 1);
+        REQUIRE(children % (Arity * sizeof(std::uint64_t) < line_size ? Arity * sizeof(std::uint64_t) : line_size) ==
+                0);
+        for (int i = 0; i < 150; ++i) {
+            REQUIRE(heap.top() == ref_pq.top());
+            heap.pop();
+            ref_pq.pop();
+        }
+    }
+    while (!heap.empty()) {
+        REQUIRE(heap.top() == ref_pq.top());
+        heap.pop();
+        ref_pq.pop();
+    }
+    REQUIRE(ref_pq.empty());
+}
+
+TEMPLATE_TEST_CASE_SIG("key-value heap keeps keys and values together", "[heap][key_value]",
+                       ((unsigned int Arity), Arity), 2, 3, 8) {
+    using heap_t = multiqueue::KeyValueHeap<int, std::string, std::less<>, Arity>;
+
+    auto heap = heap_t{};
+    auto ref_pq = std::priority_queue<int>{};
+    auto gen = std::mt19937{0};
+    auto dist = std::uniform_int_distribution{0, 1000};
+    auto check_top = [&] {
+        REQUIRE(heap.top().first == ref_pq.top());
+        REQUIRE(heap.top().second == std::to_string(heap.top().first));
+    };
+
+    SECTION("interleave pushing and popping random numbers") {
+        for (int s = 0; s < 200; ++s) {
+            for (int i = 0; i < 20; ++i) {
+                auto n = dist(gen);
+                heap.emplace(n, std::to_string(n));
+                ref_pq.push(n);
+            }
+            for (int i = 0; i < 15; ++i) {
+                check_top();
+                auto v = heap.extract_top();
+                REQUIRE(v.second == std::to_string(v.first));
+                ref_pq.pop();
+            }
+        }
+    }
+
+    SECTION("push a range of random numbers") {
+        std::vector<std::pair<int, std::string>> values;
+        for (int i = 0; i < 1000; ++i) {
+            auto n = dist(gen);
+            values.emplace_back(n, std::to_string(n));
+            ref_pq.push(n);
+        }
+        heap.push_range(std::make_move_iterator(values.begin()), std::make_move_iterator(values.begin() + 600));
+        heap.push_range(values.begin() + 600, values.end());
+    }
+
+    REQUIRE(heap.size() == ref_pq.size());
+    while (!heap.empty()) {
+        check_top();
+        heap.pop();
+        ref_pq.pop();
+    }
+    REQUIRE(ref_pq.empty());
+}
+
 TEST_CASE("heap works with non-default-constructible types", "[heap][types]") {
     using heap_t = multiqueue::Heap<std::pair<test_types::nodefault, test_types::nodefault>, std::less<>>;
     heap_t heap{};
@@ -203,3 +396,17 @@ TEST_CASE("heap works with non-default-constructible types", "[heap][types]") {
     heap.pop();
     heap.pop();
 }
+
+TEST_CASE("heap works with move-only types", "[heap][types]") {
+    using heap_t = multiqueue::Heap<test_types::nocopy, std::less<>>;
+    heap_t heap{};
+    for (int i = 0; i < 100; ++i) {
+        test_types::nocopy t;
+        t.i = i * 7 % 100;
+        heap.push(std::move(t));
+    }
+    for (int i = 99; i >= 0; --i) {
+        REQUIRE(heap.extract_top().i == i);
+    }
+    REQUIRE(heap.empty());
+}
@@ -1,6 +1,713 @@
+#include "multiqueue/modes/hierarchical.hpp"
+#include "multiqueue/modes/node_sampler.hpp"
+#include "multiqueue/modes/random.hpp"
+#include "multiqueue/modes/stick_random.hpp"
+#include "multiqueue/modes/stick_swap.hpp"
+#include "multiqueue/multiqueue.hpp"
+#include "multiqueue/numa.hpp"
+#include "multiqueue/seqlock.hpp"
+
+#include "pcg_random.hpp"
+
+#include "catch2/catch_template_test_macros.hpp"
 #include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators_all.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+template <typename Mode>
+struct TestPolicy {
+    using mode_type = Mode;
+    static constexpr int pop_tries = 1;
+    static constexpr bool scan = true;
+};
+
+template <typename Mode>
+using mq_t = multiqueue::ValueMultiQueue<int, std::less<>, TestPolicy<Mode>>;
+
+template <typename Mode>
+struct StatsPolicy : TestPolicy<Mode> {
+    static constexpr bool collect_stats = true;
+};
+
+TEMPLATE_TEST_CASE("multiqueue returns every pushed element", "[multiqueue][basic]", multiqueue::mode::Random<>,
+                   multiqueue::mode::StickRandom<>, multiqueue::mode::StickSwap<>,
+                   multiqueue::mode::Hierarchical<>) {
+    auto mq = mq_t<TestType>(8);
+    auto handle = mq.get_handle();
+    REQUIRE_FALSE(handle.try_pop());
+
+    std::vector<int> values(1000);
+    for (int i = 0; i < 1000; ++i) {
+        values[static_cast<std::size_t>(i)] = i * 7 % 1000;
+        handle.push(values[static_cast<std::size_t>(i)]);
+    }
+
+    std::vector<int> popped;
+    while (auto v = handle.try_pop()) {
+        popped.push_back(*v);
+    }
+    std::sort(values.begin(), values.end());
+    std::sort(popped.begin(), popped.end());
+    REQUIRE(popped == values);
+}
+
+TEMPLATE_TEST_CASE("multiqueue supports bulk push", "[multiqueue][bulk]", multiqueue::mode::Random<>,
+                   multiqueue::mode::StickRandom<>, multiqueue::mode::StickSwap<>,
+                   multiqueue::mode::Hierarchical<>) {
+    auto mq = mq_t<TestType>(8);
+    auto handle = mq.get_handle();
+
+    std::vector<int> values(1000);
+    for (int i = 0; i < 1000; ++i) {
+        values[static_cast<std::size_t>(i)] = i * 7 % 1000;
+    }
+    handle.push(values.begin(), values.end());
+
+    std::vector<int> popped;
+    while (auto v = handle.try_pop()) {
+        popped.push_back(*v);
+    }
+    std::sort(values.begin(), values.end());
+    std::sort(popped.begin(), popped.end());
+    REQUIRE(popped == values);
+}
+
+TEMPLATE_TEST_CASE("multiqueue supports batched pops", "[multiqueue][bulk]", multiqueue::mode::Random<>,
+                   multiqueue::mode::StickRandom<>, multiqueue::mode::StickSwap<>,
+                   multiqueue::mode::Hierarchical<>) {
+    auto mq = mq_t<TestType>(8);
+    auto handle = mq.get_handle();
+
+    std::vector<int> values(1000);
+    for (int i = 0; i < 1000; ++i) {
+        values[static_cast<std::size_t>(i)] = i;
+        handle.push(i);
+    }
+
+    std::vector<int> popped;
+    while (true) {
+        auto n = handle.try_pop_n(std::back_inserter(popped), 10);
+        REQUIRE(n <= 10);
+        if (n == 0) {
+            break;
+        }
+    }
+    REQUIRE(handle.try_pop_n(std::back_inserter(popped), 0) == 0);
+    std::sort(popped.begin(), popped.end());
+    REQUIRE(popped == values);
+}
+
+TEST_CASE("multiqueue supports moving and emplacing values", "[multiqueue][types]") {
+    using mq_t = multiqueue::KeyValueMultiQueue<int, std::string>;
+    auto mq = mq_t(8);
+    auto handle = mq.get_handle();
+
+    for (int i = 0; i < 500; ++i) {
+        handle.emplace(i, std::to_string(i));
+    }
+    for (int i = 500; i < 1000; ++i) {
+        auto v = std::make_pair(i, std::to_string(i));
+        handle.push(std::move(v));
+    }
+    int count = 0;
+    while (auto v = handle.try_pop()) {
+        REQUIRE(v->second == std::to_string(v->first));
+        ++count;
+    }
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("multiqueue stores keys and values separately", "[multiqueue][types]") {
+    using mq_t = multiqueue::KeyValueMultiQueue<int, std::string, std::less<>, multiqueue::DefaultPolicy,
+                                                multiqueue::KeyValuePriorityQueue<int, std::string, std::less<>>>;
+    auto mq = mq_t(8);
+    auto handle = mq.get_handle();
+
+    for (int i = 0; i < 1000; ++i) {
+        handle.emplace(i * 7 % 1000, std::to_string(i * 7 % 1000));
+    }
+    int count = 0;
+    while (auto v = handle.try_pop()) {
+        REQUIRE(v->second == std::to_string(v->first));
+        ++count;
+    }
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("multiqueue supports radix heaps", "[multiqueue][types]") {
+    using mq_t = multiqueue::ValueMultiQueue<unsigned int, std::greater<>, multiqueue::DefaultPolicy,
+                                             multiqueue::RadixPriorityQueue<unsigned int, multiqueue::utils::Identity,
+                                                                            std::greater<>>>;
+    auto mq = mq_t(8);
+    auto handle = mq.get_handle();
+
+    // The queues see keys smaller than their last popped key, since the pops are relaxed
+    unsigned int last = 0;
+    int count = 0;
+    for (unsigned int i = 0; i < 1000; ++i) {
+        handle.push(last + i % 13);
+        ++count;
+        if (i % 3 == 0) {
+            if (auto v = handle.try_pop()) {
+                last = *v;
+                --count;
+            }
+        }
+    }
+    while (handle.try_pop()) {
+        --count;
+    }
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("multiqueue supports bucket queues", "[multiqueue][types]") {
+    auto mq = multiqueue::BucketMultiQueue<int>(8);
+    auto handle = mq.get_handle();
+
+    for (int i = 0; i < 1000; ++i) {
+        handle.push(i * 7 % 4096);
+    }
+    int count = 0;
+    while (auto v = handle.try_pop()) {
+        REQUIRE(*v >= 0);
+        REQUIRE(*v < 4096);
+        ++count;
+    }
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("multiqueue supports bucket queues of unsigned keys including 0", "[multiqueue][types]") {
+    auto mq = multiqueue::BucketMultiQueue<unsigned int>(1);
+    auto handle = mq.get_handle();
+
+    handle.push(0U);
+    auto v = handle.try_pop();
+    REQUIRE(v);
+    REQUIRE(*v == 0U);
+    REQUIRE(!handle.try_pop());
+
+    for (unsigned int i = 0; i < 10; ++i) {
+        handle.push(i);
+    }
+    for (unsigned int i = 10; i-- > 0;) {
+        v = handle.try_pop();
+        REQUIRE(v);
+        REQUIRE(*v == i);
+    }
+    REQUIRE(!handle.try_pop());
+}
+
+TEMPLATE_TEST_CASE("multiqueue terminates when all handles are idle", "[multiqueue][blocking]",
+                   multiqueue::mode::Random<>, multiqueue::mode::StickRandom<>, multiqueue::mode::StickSwap<>,
+                   multiqueue::mode::Hierarchical<>) {
+    static constexpr int num_threads = 4;
+    auto mq = mq_t<TestType>(16);
+
+    // All handles have to exist before any of them blocks, otherwise the multiqueue could terminate prematurely
+    std::vector<typename mq_t<TestType>::handle_type> handles;
+    for (int i = 0; i < num_threads; ++i) {
+        handles.push_back(mq.get_handle());
+    }
+    for (int i = 0; i < 100; ++i) {
+        handles[0].push(10);
+    }
+
+    std::atomic_int num_popped{0};
+    std::vector<std::thread> threads;
+    for (auto& h : handles) {
+        threads.emplace_back([&num_popped, handle = std::move(h)]() mutable {
+            while (auto v = handle.pop()) {
+                num_popped.fetch_add(1, std::memory_order_relaxed);
+                if (*v > 0) {
+                    handle.push(*v - 1);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    REQUIRE(mq.terminated());
+    REQUIRE(num_popped.load() == 100 * 11);
+}
+
+TEST_CASE("multiqueue can be refilled after termination", "[multiqueue][blocking]") {
+    using mq_t = mq_t<multiqueue::mode::Random<>>;
+    auto mq = mq_t(8);
+    auto handle = mq.get_handle();
+
+    handle.push(1);
+    REQUIRE(handle.pop() == std::optional<int>{1});
+    REQUIRE_FALSE(handle.pop().has_value());
+    REQUIRE(mq.terminated());
+
+    handle.push(2);
+    REQUIRE_FALSE(mq.terminated());
+    REQUIRE(handle.pop() == std::optional<int>{2});
+    REQUIRE_FALSE(handle.pop().has_value());
+    REQUIRE(mq.terminated());
+
+    std::vector<int> values{3, 4, 5};
+    mq.assign(values.begin(), values.end());
+    REQUIRE_FALSE(mq.terminated());
+    int num_popped = 0;
+    while (handle.pop()) {
+        ++num_popped;
+    }
+    REQUIRE(num_popped == 3);
+    REQUIRE(mq.terminated());
+}
+
+TEST_CASE("multiqueue pop_for times out", "[multiqueue][blocking]") {
+    auto mq = mq_t<multiqueue::mode::Random<>>(8);
+    auto handle = mq.get_handle();
+    auto other_handle = mq.get_handle();
+
+    REQUIRE_FALSE(handle.pop_for(std::chrono::milliseconds(10)).has_value());
+    REQUIRE_FALSE(mq.terminated());
+    other_handle.push(1);
+    auto v = handle.pop_for(std::chrono::milliseconds(10));
+    REQUIRE(v.has_value());
+    REQUIRE(*v == 1);
+}
+
+TEST_CASE("multiqueue can be constructed with an initial capacity", "[multiqueue][numa]") {
+    using mq_t = mq_t<multiqueue::mode::Random<>>;
+    // The storage of the queues is reserved on the nodes of the queues before the handles touch it
+    auto mq = mq_t(8, std::size_t{1000});
+    REQUIRE(mq.num_pqs() == 8);
+    auto handle = mq.get_handle();
+
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 0);
+    handle.push(values.begin(), values.end());
+    std::vector<int> popped;
+    while (auto v = handle.try_pop()) {
+        popped.push_back(*v);
+    }
+    std::sort(popped.begin(), popped.end());
+    REQUIRE(popped == values);
+}
+
+TEST_CASE("multiqueue can be constructed from values", "[multiqueue][assign]") {
+    using mq_t = mq_t<multiqueue::mode::Random<>>;
+    auto num_threads = GENERATE(1U, 3U);
+    auto num_values = GENERATE(0, 5, 100'000);
+
+    std::vector<int> values(static_cast<std::size_t>(num_values));
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<int>(i);
+    }
+    auto mq = mq_t(8, values.begin(), values.end(), num_threads);
+    auto handle = mq.get_handle();
+
+    std::vector<int> popped;
+    while (auto v = handle.try_pop()) {
+        popped.push_back(*v);
+    }
+    std::sort(popped.begin(), popped.end());
+    REQUIRE(popped == values);
+
+    mq.assign(values.begin(), values.end(), num_threads);
+    popped.clear();
+    while (auto v = handle.try_pop()) {
+        popped.push_back(*v);
+    }
+    std::sort(popped.begin(), popped.end());
+    REQUIRE(popped == values);
+}
+
+TEST_CASE("multiqueue clamps the number of threads to assign with", "[multiqueue][assign]") {
+    using mq_t = mq_t<multiqueue::mode::Random<>>;
+    // No threads still fills the queues, and threads beyond one per queue have nothing to do
+    auto num_threads = GENERATE(0U, 20U);
+
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 0);
+    auto mq = mq_t(8);
+    mq.assign(values.begin(), values.end(), num_threads);
+    auto handle = mq.get_handle();
+
+    std::vector<int> popped;
+    while (auto v = handle.try_pop()) {
+        popped.push_back(*v);
+    }
+    std::sort(popped.begin(), popped.end());
+    REQUIRE(popped == values);
+}
+
+TEMPLATE_TEST_CASE("multiqueue counts its elements", "[multiqueue][size]", multiqueue::mode::Random<>,
+                   multiqueue::mode::StickRandom<>, multiqueue::mode::StickSwap<>,
+                   multiqueue::mode::Hierarchical<>) {
+    std::vector<int> values(100);
+    std::iota(values.begin(), values.end(), 0);
+    auto mq = mq_t<TestType>(8, values.begin(), values.end(), 1);
+    REQUIRE(mq.approx_size() == 100);
+    {
+        auto handle = mq.get_handle();
+        handle.push(1);
+        handle.emplace(2);
+        handle.push(values.begin(), values.end());
+        REQUIRE(mq.approx_size() == 202);
+        std::vector<int> popped;
+        REQUIRE(handle.try_pop_n(std::back_inserter(popped), 2) == 2);
+        REQUIRE(handle.try_pop().has_value());
+        REQUIRE(mq.approx_size() == 199);
+    }
+    // Counts of destroyed handles are kept
+    REQUIRE(mq.approx_size() == 199);
+    auto handle = mq.get_handle();
+    while (handle.try_pop()) {
+    }
+    REQUIRE(mq.approx_size() == 0);
+    REQUIRE(mq.maybe_empty());
+}
+
+TEMPLATE_TEST_CASE("multiqueue can be resized while in use", "[multiqueue][resize]", multiqueue::mode::Random<>,
+                   multiqueue::mode::StickRandom<>, multiqueue::mode::StickSwap<>,
+                   multiqueue::mode::Hierarchical<>) {
+    static constexpr int num_threads = 2;
+    static constexpr int num_values = 20'000;
+    auto mq = mq_t<TestType>(16, multiqueue::MaxPQs{32});
+    REQUIRE(mq.num_pqs() == 16);
+    REQUIRE(mq.max_num_pqs() == 32);
+
+    std::vector<std::vector<int>> popped(num_threads);
+    std::atomic_int num_done{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            auto handle = mq.get_handle();
+            for (int i = t; i < num_values; i += num_threads) {
+                handle.push(i);
+                if (i % 3 == 0) {
+                    if (auto v = handle.try_pop()) {
+                        popped[static_cast<std::size_t>(t)].push_back(*v);
+                    }
+                }
+            }
+            num_done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    // Grows and shrinks by several steps at once. Handles share queues at any size, so the smallest size is arbitrary;
+    // shrinking below the number of pop candidates is tested separately.
+    std::size_t const sizes[] = {32, 8, 16, 4, 32};
+    for (std::size_t i = 0; num_done.load(std::memory_order_acquire) != num_threads; ++i) {
+        mq.resize(sizes[i % std::size(sizes)]);
+        std::this_thread::yield();
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    mq.resize(4);
+    REQUIRE(mq.num_pqs() == 4);
+    auto handle = mq.get_handle();
+    std::vector<int> all;
+    for (auto const& p : popped) {
+        all.insert(all.end(), p.begin(), p.end());
+    }
+    while (auto v = handle.try_pop()) {
+        all.push_back(*v);
+    }
+    std::sort(all.begin(), all.end());
+    std::vector<int> values(num_values);
+    std::iota(values.begin(), values.end(), 0);
+    REQUIRE(all == values);
+    REQUIRE(mq.approx_size() == 0);
+}
+
+TEMPLATE_TEST_CASE("multiqueue works with a single queue", "[multiqueue][resize]", multiqueue::mode::Random<>,
+                   multiqueue::mode::StickRandom<>, multiqueue::mode::Hierarchical<>) {
+    auto mq = mq_t<TestType>(1, multiqueue::MaxPQs{4});
+    auto handle = mq.get_handle();
+    for (int i = 0; i < 100; ++i) {
+        handle.push(i);
+    }
+    mq.resize(4);
+    mq.resize(1);
+    for (int i = 99; i >= 0; --i) {
+        auto v = handle.try_pop();
+        REQUIRE(v);
+        REQUIRE(*v == i);
+    }
+    REQUIRE(!handle.try_pop());
+}
+
+TEMPLATE_TEST_CASE("multiqueue can shrink below the number of pop candidates while in use", "[multiqueue][resize]",
+                   multiqueue::mode::Random<4>, multiqueue::mode::StickRandom<4>) {
+    static constexpr int num_threads = 2;
+    static constexpr int num_values = 20'000;
+    auto mq = mq_t<TestType>(4, multiqueue::MaxPQs{8});
+
+    std::atomic_int num_popped{0};
+    std::atomic_int num_done{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            auto handle = mq.get_handle();
+            for (int i = t; i < num_values; i += num_threads) {
+                handle.push(i);
+                if (handle.try_pop()) {
+                    num_popped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            num_done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    // The candidates are drawn while the queues shrink from at least as many queues as candidates to fewer
+    std::size_t const sizes[] = {8, 1, 4, 2, 8, 2};
+    for (std::size_t i = 0; num_done.load(std::memory_order_acquire) != num_threads; ++i) {
+        mq.resize(sizes[i % std::size(sizes)]);
+        std::this_thread::yield();
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    mq.resize(1);
+    auto handle = mq.get_handle();
+    int num_remaining = 0;
+    while (handle.try_pop()) {
+        ++num_remaining;
+    }
+    REQUIRE(num_popped.load() + num_remaining == num_values);
+}
+
+TEMPLATE_TEST_CASE("multiqueue collects operation statistics", "[multiqueue][stats]", multiqueue::mode::Random<>,
+                   multiqueue::mode::StickRandom<>, multiqueue::mode::StickSwap<>,
+                   multiqueue::mode::Hierarchical<>) {
+    using stats_mq_t = multiqueue::ValueMultiQueue<int, std::less<>, StatsPolicy<TestType>>;
+    auto mq = stats_mq_t(8);
+    {
+        auto handle = mq.get_handle();
+        std::vector<int> values(100);
+        std::iota(values.begin(), values.end(), 0);
+        handle.push(values.begin(), values.end());
+        handle.push(100);
+        std::vector<int> popped;
+        REQUIRE(handle.try_pop_n(std::back_inserter(popped), 5) > 0);
+        while (handle.try_pop()) {
+        }
+    }
+    auto stats = mq.stats();
+    REQUIRE(stats.pushes == 101);
+    REQUIRE(stats.pops == 101);
+    // The final pop can only fail after scanning
+    REQUIRE(stats.scans >= 1);
+    REQUIRE(stats.empty_pops >= 1);
+
+    std::ostringstream out;
+    stats.write_json(out);
+    REQUIRE(out.str().find("\"pushes\":101,\"pops\":101") != std::string::npos);
+
+    // Disabled statistics are always zero
+    auto plain_mq = mq_t<TestType>(8);
+    plain_mq.get_handle().push(1);
+    REQUIRE(plain_mq.stats().pushes == 0);
+}
+
+TEST_CASE("nonempty bitmap finds the next set bit", "[multiqueue][bitmap]") {
+    static constexpr std::size_t size = 5000;
+    auto bitmap = multiqueue::NonEmptyBitmap(size);
+    REQUIRE_FALSE(bitmap.any(size));
+    REQUIRE(bitmap.find_next(0, size) == size);
+
+    bitmap.set(4100);
+    bitmap.set(7);
+    REQUIRE(bitmap.test(7));
+    REQUIRE(bitmap.find_first(0, size) == 7);
+    REQUIRE(bitmap.find_first(8, size) == 4100);
+    REQUIRE(bitmap.find_first(8, 4100) == 4100);
+    REQUIRE(bitmap.find_next(4101, size) == 7);
+    bitmap.reset(7);
+    REQUIRE_FALSE(bitmap.test(7));
+    REQUIRE(bitmap.find_next(4101, size) == 4100);
+    bitmap.reset(4100);
+    REQUIRE_FALSE(bitmap.any(size));
+}
+
+struct NoScanPolicy : TestPolicy<multiqueue::mode::Random<>> {
+    static constexpr bool scan = false;
+};
+
+TEST_CASE("multiqueue finds a single element without scanning", "[multiqueue][bitmap]") {
+    auto mq = multiqueue::ValueMultiQueue<int, std::less<>, NoScanPolicy>(64);
+    auto handle = mq.get_handle();
+    for (int i = 0; i < 100; ++i) {
+        handle.push(i);
+        auto v = handle.try_pop();
+        REQUIRE(v.has_value());
+        REQUIRE(*v == i);
+    }
+    REQUIRE_FALSE(handle.try_pop().has_value());
+}
+
+// Mimics the NUMA interface of the multiqueue context with a fixed number of nodes and a resizable number of queues
+struct FakeNumaContext {
+    multiqueue::numa::Placement placement;
+    std::size_t num_pqs;
+
+    [[nodiscard]] int num_nodes() const noexcept {
+        return placement.num_nodes();
+    }
+
+    [[nodiscard]] std::pair<std::size_t, std::size_t> node_pqs(int node, std::size_t n) const noexcept {
+        return placement.node_pqs(node, n);
+    }
+};
+
+TEST_CASE("node-local queues stay on their nodes when resizing", "[multiqueue][numa]") {
+    static constexpr std::size_t max_num_pqs = 64;
+    auto ctx = FakeNumaContext{multiqueue::numa::Placement(max_num_pqs, 4), max_num_pqs};
+    REQUIRE(ctx.num_nodes() == 4);
+    auto sample = multiqueue::mode::detail::NodeSampler(0.0);
+    pcg32 rng{};
+
+    for (; ctx.num_pqs > 0; ctx.num_pqs /= 2) {
+        std::size_t covered = 0;
+        for (int node = 0; node < ctx.num_nodes(); ++node) {
+            // The active queues of a node have to be among the queues whose memory is bound to the node
+            auto [bound_first, bound_last] = ctx.placement.node_pqs(node);
+            auto [first, last] = ctx.node_pqs(node, ctx.num_pqs);
+            REQUIRE(first <= last);
+            if (first != last) {
+                REQUIRE(first == covered);
+                REQUIRE(first >= bound_first);
+                REQUIRE(last <= bound_last);
+            }
+            REQUIRE(last <= ctx.num_pqs);
+            covered = std::max(covered, last);
+        }
+        REQUIRE(covered == ctx.num_pqs);
+
+        auto const node = multiqueue::numa::current_node() % ctx.num_nodes();
+        auto [first, last] = ctx.node_pqs(node, ctx.num_pqs);
+        for (int i = 0; i < 100; ++i) {
+            auto pq = sample(ctx, ctx.num_pqs, 1, rng);
+            REQUIRE(pq < ctx.num_pqs);
+            if (first != last) {
+                REQUIRE(pq >= first);
+                REQUIRE(pq < last);
+            }
+        }
+    }
+}
+
+TEST_CASE("cache domains cover all cpus", "[multiqueue][topology]") {
+    auto domains = multiqueue::topology::CacheDomains(3);
+    REQUIRE(domains.num_domains() >= 1);
+    auto const num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < num_cpus; ++cpu) {
+        REQUIRE(domains.domain_of(cpu) >= 0);
+        REQUIRE(domains.domain_of(cpu) < domains.num_domains());
+    }
+}
+
+TEST_CASE("hierarchical mode works with more domains than queues", "[multiqueue][topology]") {
+    using hierarchical_t = multiqueue::mode::Hierarchical<>;
+    auto config = mq_t<hierarchical_t>::config_type{};
+    // Every cpu is its own domain, so the group of this handle has at most one queue
+    config.cores_per_domain = 1;
+    auto num_pqs = GENERATE(1, 2, 8);
+    auto mq = mq_t<hierarchical_t>(static_cast<std::size_t>(num_pqs), config);
+    auto handle = mq.get_handle();
+    for (int i = 0; i < 1000; ++i) {
+        handle.push(i);
+    }
+    int count = 0;
+    while (handle.try_pop()) {
+        ++count;
+    }
+    REQUIRE(count == 1000);
+}
+
+struct CompositeKey {
+    std::uint64_t deadline;
+    std::uint64_t tenant;
+
+    friend bool operator==(CompositeKey const& lhs, CompositeKey const& rhs) noexcept {
+        return lhs.deadline == rhs.deadline && lhs.tenant == rhs.tenant;
+    }
+
+    friend bool operator!=(CompositeKey const& lhs, CompositeKey const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+};
+
+struct CompositeKeyGreater {
+    bool operator()(CompositeKey const& lhs, CompositeKey const& rhs) const noexcept {
+        return std::pair{lhs.deadline, lhs.tenant} > std::pair{rhs.deadline, rhs.tenant};
+    }
+};
+
+TEST_CASE("seqlock never returns torn values", "[multiqueue][seqlock]") {
+    auto value = multiqueue::SeqLock<CompositeKey>(CompositeKey{0, ~std::uint64_t{0}});
+    std::atomic_bool done{false};
+    std::thread writer([&] {
+        for (std::uint64_t i = 1; i <= 100'000; ++i) {
+            value.store(CompositeKey{i, ~i});
+        }
+        done.store(true);
+    });
+    bool torn = false;
+    while (!done.load()) {
+        auto key = value.load();
+        torn = torn || key.tenant != ~key.deadline;
+    }
+    writer.join();
+    REQUIRE_FALSE(torn);
+    REQUIRE(value.load() == CompositeKey{100'000, ~std::uint64_t{100'000}});
+}
+
+TEST_CASE("seqlock supports values without default constructor", "[multiqueue][seqlock]") {
+    struct Key {
+        std::uint64_t a;
+        std::uint64_t b;
+
+        Key(std::uint64_t x, std::uint64_t y) noexcept : a{x}, b{y} {
+        }
+    };
+    static_assert(!std::is_default_constructible_v<Key>);
+
+    auto value = multiqueue::SeqLock<Key>(Key{1, 2});
+    REQUIRE(value.load().a == 1);
+    value.store(Key{3, 4});
+    auto key = value.load();
+    REQUIRE(key.a == 3);
+    REQUIRE(key.b == 4);
+}
 
-TEST_CASE("multiqueue TODO", "[multiqueue][.shouldfail]") {
-  INFO("No tests for multiqueue yet!");
-  REQUIRE(false);
+TEST_CASE("multiqueue supports composite keys", "[multiqueue][seqlock]") {
+    using mq_t = multiqueue::KeyValueMultiQueue<
+        CompositeKey, int, CompositeKeyGreater, TestPolicy<multiqueue::mode::Random<>>,
+        multiqueue::DefaultPriorityQueue<std::pair<CompositeKey, int>, multiqueue::utils::PairFirst,
+                                         CompositeKeyGreater>,
+        multiqueue::sentinel::DefaultConstruct<CompositeKey, CompositeKeyGreater>>;
+    auto mq = mq_t(4);
+    auto handle = mq.get_handle();
+    // The default constructed key {0, 0} is the sentinel
+    for (std::uint64_t i = 1; i <= 1000; ++i) {
+        handle.push({CompositeKey{i % 10 + 1, i}, static_cast<int>(i)});
+    }
+    int count = 0;
+    while (auto v = handle.try_pop()) {
+        REQUIRE(v->first.tenant == static_cast<std::uint64_t>(v->second));
+        ++count;
+    }
+    REQUIRE(count == 1000);
 }
@@ -0,0 +1,114 @@
+#include "multiqueue/buffered_pq.hpp"
+#include "multiqueue/radix_heap.hpp"
+#include "multiqueue/utils.hpp"
+#include "test_types.hpp"
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEMPLATE_TEST_CASE("radix heap pops keys of dijkstra-like workloads in order", "[radix_heap][monotone]",
+                   std::uint32_t, std::int64_t) {
+    // Pops the top and pushes keys that are at most `max_decrease` better than it. `sign` is 1 for min-queues and -1
+    // for max-queues.
+    auto run = [](auto pq, int max_decrease, int sign) {
+        auto gen = std::mt19937{0};
+        auto dist = std::uniform_int_distribution{-max_decrease, 100};
+        auto seq_dist = std::uniform_int_distribution{1, 10};
+        pq.push(TestType{1000});
+        for (int s = 0; s < 2000 && !pq.empty(); ++s) {
+            auto top = pq.pop();
+            auto num_push = seq_dist(gen);
+            for (int i = 0; i < num_push; ++i) {
+                pq.push(static_cast<TestType>(static_cast<long long>(top) + sign * dist(gen)));
+            }
+        }
+        pq.drain();
+    };
+    using min_heap_t = multiqueue::RadixHeap<TestType>;
+    using max_heap_t = multiqueue::RadixHeap<TestType, multiqueue::utils::Identity, std::less<>>;
+
+    SECTION("monotone keys") {
+        run(test_types::checked_pq<min_heap_t, std::greater<>>{}, 0, 1);
+        run(test_types::checked_pq<max_heap_t, std::less<>>{}, 0, -1);
+    }
+    SECTION("keys better than the last popped key") {
+        run(test_types::checked_pq<min_heap_t, std::greater<>>{}, 50, 1);
+        run(test_types::checked_pq<max_heap_t, std::less<>>{}, 50, -1);
+        run(test_types::checked_pq<multiqueue::BufferedPQ<min_heap_t>, std::greater<>>{}, 50, 1);
+    }
+}
+
+TEST_CASE("radix heap supports negative keys", "[radix_heap][types]") {
+    SECTION("min-queue") {
+        // Ascending keys are never better than the first one, so they all go into the buckets
+        auto pq = multiqueue::RadixHeap<int>{};
+        for (int i = -100; i <= 100; ++i) {
+            pq.push(i);
+        }
+        for (int i = -100; i <= 100; ++i) {
+            REQUIRE(pq.top() == i);
+            pq.pop();
+        }
+        REQUIRE(pq.empty());
+    }
+    SECTION("max-queue") {
+        auto pq = multiqueue::RadixHeap<int, multiqueue::utils::Identity, std::less<>>{};
+        for (int i = 100; i >= -100; --i) {
+            pq.push(i);
+        }
+        for (int i = 100; i >= -100; --i) {
+            REQUIRE(pq.top() == i);
+            pq.pop();
+        }
+        REQUIRE(pq.empty());
+    }
+    SECTION("shuffled with pops in between") {
+        auto pq = multiqueue::RadixHeap<int>{};
+        auto ref_pq = std::priority_queue<int, std::vector<int>, std::greater<>>{};
+        std::vector<int> keys(2001);
+        std::iota(keys.begin(), keys.end(), -1000);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937{0});
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            pq.push(keys[i]);
+            ref_pq.push(keys[i]);
+            if (i % 3 == 0) {
+                REQUIRE(pq.top() == ref_pq.top());
+                pq.pop();
+                ref_pq.pop();
+            }
+        }
+        while (!ref_pq.empty()) {
+            REQUIRE(pq.top() == ref_pq.top());
+            pq.pop();
+            ref_pq.pop();
+        }
+        REQUIRE(pq.empty());
+    }
+}
+
+TEST_CASE("radix heap stores key-value pairs", "[radix_heap][types]") {
+    using value_type = std::pair<std::uint64_t, std::string>;
+    auto pq = multiqueue::RadixHeap<value_type, multiqueue::utils::PairFirst>{};
+    std::vector<value_type> values;
+    for (std::uint64_t i = 0; i < 100; ++i) {
+        values.emplace_back(i * 37 % 100, std::to_string(i * 37 % 100));
+    }
+    pq.push_range(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+    for (std::uint64_t i = 0; i < 100; ++i) {
+        auto v = pq.extract_top();
+        REQUIRE(v.first == i);
+        REQUIRE(v.second == std::to_string(i));
+    }
+    REQUIRE(pq.empty());
+}
@@ -0,0 +1,61 @@
+#include "multiqueue/buffered_pq.hpp"
+#include "multiqueue/sequence_heap.hpp"
+#include "test_types.hpp"
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include <functional>
+#include <memory>
+#include <random>
+
+TEST_CASE("sequence heap pops in order", "[sequence_heap]") {
+    // Phases of more pushes than pops followed by phases of more pops than pushes, so that runs of all groups are
+    // merged and partially consumed
+    auto run = [](auto pq, int max_key) {
+        auto gen = std::mt19937{0};
+        auto dist = std::uniform_int_distribution{0, max_key};
+        for (int phase = 0; phase < 6; ++phase) {
+            auto const num_push = phase % 2 == 0 ? 7 : 2;
+            auto const num_pop = phase % 2 == 0 ? 3 : 5;
+            for (int s = 0; s < 2000 && !(num_pop > num_push && pq.size() < 10); ++s) {
+                for (int i = 0; i < num_push; ++i) {
+                    pq.push(dist(gen));
+                }
+                for (int i = 0; i < num_pop; ++i) {
+                    pq.pop();
+                }
+            }
+        }
+        pq.drain();
+    };
+
+    SECTION("random keys") {
+        run(test_types::checked_pq<multiqueue::SequenceHeap<int, std::less<>>, std::less<>>{}, 1'000'000);
+        run(test_types::checked_pq<multiqueue::SequenceHeap<int, std::greater<>>, std::greater<>>{}, 1'000'000);
+        // Few distinct values
+        run(test_types::checked_pq<multiqueue::SequenceHeap<int, std::greater<>>, std::greater<>>{}, 20);
+    }
+    SECTION("runs of small groups") {
+        run(test_types::checked_pq<multiqueue::SequenceHeap<int, std::less<>, 1, 2>, std::less<>>{}, 1'000'000);
+        run(test_types::checked_pq<multiqueue::SequenceHeap<int, std::greater<>, 4, 3>, std::greater<>>{}, 1'000);
+    }
+    SECTION("in a buffered pq") {
+        run(test_types::checked_pq<multiqueue::BufferedPQ<multiqueue::SequenceHeap<int, std::greater<>, 16>>,
+                                   std::greater<>>{},
+            1'000'000);
+    }
+}
+
+TEST_CASE("sequence heap moves values", "[sequence_heap][types]") {
+    auto comp = [](std::unique_ptr<int> const& lhs, std::unique_ptr<int> const& rhs) { return *lhs > *rhs; };
+    auto heap = multiqueue::SequenceHeap<std::unique_ptr<int>, decltype(comp), 8, 2>(comp);
+    for (int i = 0; i < 500; ++i) {
+        heap.push(std::make_unique<int>(i * 7 % 500));
+    }
+    for (int i = 0; i < 500; ++i) {
+        auto v = heap.extract_top();
+        REQUIRE(*v == i);
+    }
+    REQUIRE(heap.empty());
+}
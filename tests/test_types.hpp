@@ -2,6 +2,12 @@
 #ifndef TEST_TYPES_HPP_INCLUDED
 #define TEST_TYPES_HPP_INCLUDED
 
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef>
+#include <queue>
+#include <vector>
+
 namespace test_types {
 
 struct nocopy {
@@ -44,6 +50,49 @@ struct countingcmp {
     static inline int count = 0;
 };
 
+// Mirrors every operation on a priority queue to a `std::priority_queue` and checks that both agree
+template <typename PQ, typename Compare>
+class checked_pq {
+   public:
+    using value_type = typename PQ::value_type;
+
+   private:
+    PQ pq_;
+    std::priority_queue<value_type, std::vector<value_type>, Compare> ref_pq_;
+
+   public:
+    void push(value_type const& v) {
+        pq_.push(v);
+        ref_pq_.push(v);
+    }
+
+    value_type pop() {
+        REQUIRE(!ref_pq_.empty());
+        REQUIRE(pq_.top() == ref_pq_.top());
+        auto top = ref_pq_.top();
+        pq_.pop();
+        ref_pq_.pop();
+        return top;
+    }
+
+    bool empty() {
+        REQUIRE(pq_.size() == ref_pq_.size());
+        return ref_pq_.empty();
+    }
+
+    std::size_t size() {
+        REQUIRE(pq_.size() == ref_pq_.size());
+        return ref_pq_.size();
+    }
+
+    void drain() {
+        while (!empty()) {
+            pop();
+        }
+        REQUIRE(pq_.empty());
+    }
+};
+
 }  // namespace test_types
 
 #endif  //! TEST_TYPES_HPP_INCLUDED